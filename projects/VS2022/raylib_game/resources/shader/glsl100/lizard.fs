@@ -0,0 +1,35 @@
+#version 100
+
+#extension GL_OES_standard_derivatives : enable
+#extension GL_EXT_shader_texture_lod : enable
+
+precision mediump float;
+
+// Input vertex attributes (from vertex shader)
+varying vec2 fragTexCoord;
+varying vec2 fragTileCoord;
+varying float fragLight;
+
+// Input uniform values
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+
+// Size of one block tile inside the atlas, in texture coordinates
+uniform vec2 tileSize;
+
+void main()
+{
+    // Repeat the block texture across merged faces without leaving its atlas tile
+    vec2 atlasCoord = fragTileCoord + fract(fragTexCoord)*tileSize;
+
+    // Texel color fetching from texture sampler, the mipmap level comes from the unwrapped coordinates
+    // so it does not jump to the finest level where fract() wraps (needs both extensions)
+#if defined(GL_OES_standard_derivatives) && defined(GL_EXT_shader_texture_lod)
+    vec2 unwrapped = fragTexCoord*tileSize;
+    vec4 texelColor = texture2DGradEXT(texture0, atlasCoord, dFdx(unwrapped), dFdy(unwrapped));
+#else
+    vec4 texelColor = texture2D(texture0, atlasCoord);
+#endif
+
+    gl_FragColor = vec4(texelColor.rgb*fragLight, texelColor.a)*colDiffuse;
+}
@@ -0,0 +1,29 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec2 fragTexCoord;
+in vec2 fragTileCoord;
+in float fragLight;
+
+// Input uniform values
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+
+// Output fragment color
+out vec4 finalColor;
+
+// Size of one block tile inside the atlas, in texture coordinates
+uniform vec2 tileSize;
+
+void main()
+{
+    // Repeat the block texture across merged faces without leaving its atlas tile
+    vec2 atlasCoord = fragTileCoord + fract(fragTexCoord)*tileSize;
+
+    // Texel color fetching from texture sampler, the mipmap level comes from the unwrapped coordinates
+    // so it does not jump to the finest level where fract() wraps
+    vec2 unwrapped = fragTexCoord*tileSize;
+    vec4 texelColor = textureGrad(texture0, atlasCoord, dFdx(unwrapped), dFdy(unwrapped));
+
+    finalColor = vec4(texelColor.rgb*fragLight, texelColor.a)*colDiffuse;
+}
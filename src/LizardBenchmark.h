@@ -0,0 +1,312 @@
+/*******************************************************************************************
+*
+*   LizardBenchmark * Scripted camera flythrough benchmark
+*
+*   A flythrough path is a list of camera keys (time, position, target) the camera is moved along
+*   with linear interpolation. Paths are text files with one "time px py pz tx ty tz" key per
+*   line, recorded in game (see RecordFlythroughKey()) or written by hand, or generated with
+*   GenerateFlythroughPath().
+*
+*   The benchmark first waits for the world around the start of the path to finish loading, then
+*   plays the path back with a fixed timestep of BENCHMARK_TIMESTEP per frame, however long frames
+*   really take, so every run renders the same views. Each frame records the time since the
+*   previous frame (including the buffer swap), the CPU time spent before the swap and the render
+*   counters passed to EndBenchmarkFrame(). At the end SaveBenchmarkResults() writes them as a per
+*   frame CSV plus a summary with average, p95 and p99 times. Run it unthrottled and without vsync.
+*   Nothing here needs a GPU: with Mesa the same build runs on llvmpipe (LIBGL_ALWAYS_SOFTWARE=1).
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <stdio.h>                          // Required for: FILE, fopen(), fprintf(), sscanf(), snprintf()
+#include <stdlib.h>                         // Required for: qsort()
+
+#define MAX_FLYTHROUGH_KEYS 4096
+#define BENCHMARK_TIMESTEP (1.0f/60.0f)     // Path time advanced per benchmark frame, in seconds
+#define BENCHMARK_MAX_WARMUP_TIME 60.0     // Seconds the benchmark waits for the world to load at most
+#define FLYTHROUGH_RECORD_INTERVAL 0.1f     // Seconds between recorded keys
+
+typedef struct {
+    float time;                             // Seconds since the start of the path
+    Vector3 position;
+    Vector3 target;
+} FlythroughKey;
+
+typedef struct {
+    FlythroughKey keys[MAX_FLYTHROUGH_KEYS]; // Sorted by time
+    int keyCount;
+} FlythroughPath;
+
+// Render counters and timings of one benchmark frame
+typedef struct {
+    float frameTime;                        // Start of this frame to start of the next, in milliseconds
+    float cpuTime;                          // Start of this frame to right before the buffer swap, in milliseconds
+    int sectionsDrawn;
+    int drawCalls;
+    int triangles;
+    int remeshes;                           // Section meshes uploaded this frame
+    int vramKB;                             // GPU memory held by chunk meshes, in kilobytes
+    Vector3 position;                       // Camera position
+} BenchmarkFrame;
+
+enum BenchmarkState
+{
+    BenchmarkOff,
+    BenchmarkWarmup,                        // Waiting for the world at the start of the path
+    BenchmarkRunning,
+    BenchmarkDone,
+};
+
+int benchmarkState = BenchmarkOff;
+FlythroughPath benchmarkPath = { 0 };
+BenchmarkFrame* benchmarkFrames = NULL;
+int benchmarkFrameCount = 0;                // Frames recorded so far
+int benchmarkFrameCapacity = 0;
+int benchmarkWarmupFrames = 0;
+double benchmarkWarmupTime = 0.0;           // Seconds spent waiting for the world
+double benchmarkFrameStart = 0.0;
+double benchmarkStartTime = 0.0;
+
+// Add a key at the end of a path, keys must come in time order. Returns false once the path is full
+bool RecordFlythroughKey(FlythroughPath* path, float time, Vector3 position, Vector3 target)
+{
+    if (path->keyCount == MAX_FLYTHROUGH_KEYS) return false;
+    path->keys[path->keyCount++] = (FlythroughKey){ time, position, target };
+    return true;
+}
+
+// Load a path from a text file, lines that do not hold a key (like # comments) are skipped
+bool LoadFlythroughPath(const char* fileName, FlythroughPath* path)
+{
+    FILE* file = fopen(fileName, "r");
+    if (file == NULL)
+    {
+        TraceLog(LOG_WARNING, "BENCHMARK: [%s] Failed to open flythrough path", fileName);
+        return false;
+    }
+
+    path->keyCount = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        FlythroughKey key = { 0 };
+        int count = sscanf(line, "%f %f %f %f %f %f %f", &key.time, &key.position.x, &key.position.y, &key.position.z, &key.target.x, &key.target.y, &key.target.z);
+        if (count != 7) continue;
+        if ((path->keyCount > 0) && (key.time < path->keys[path->keyCount - 1].time)) continue;
+        if (!RecordFlythroughKey(path, key.time, key.position, key.target)) break;
+    }
+    fclose(file);
+
+    TraceLog(LOG_INFO, "BENCHMARK: [%s] Flythrough path loaded, %i keys", fileName, path->keyCount);
+    return (path->keyCount > 0);
+}
+
+bool SaveFlythroughPath(const char* fileName, const FlythroughPath* path)
+{
+    FILE* file = fopen(fileName, "w");
+    if (file == NULL) return false;
+
+    fprintf(file, "# time position.x position.y position.z target.x target.y target.z\n");
+    for (int i = 0; i < path->keyCount; i++)
+    {
+        const FlythroughKey* key = &path->keys[i];
+        fprintf(file, "%.3f %.3f %.3f %.3f %.3f %.3f %.3f\n", key->time, key->position.x, key->position.y, key->position.z, key->target.x, key->target.y, key->target.z);
+    }
+    fclose(file);
+
+    TraceLog(LOG_INFO, "BENCHMARK: [%s] Flythrough path saved, %i keys", fileName, path->keyCount);
+    return true;
+}
+
+// Built-in path: one loop around center at the given radius and height above it, looking ahead and a little
+// down, followed by a straight pass through the middle
+void GenerateFlythroughPath(FlythroughPath* path, Vector3 center, float radius, float height, float duration)
+{
+    const int loopKeys = 64;
+    float loopTime = duration*0.75f;
+    path->keyCount = 0;
+
+    for (int i = 0; i <= loopKeys; i++)
+    {
+        float angle = 2.0f*PI*i/loopKeys;
+        Vector3 position = { center.x + cosf(angle)*radius, center.y + height, center.z + sinf(angle)*radius };
+        Vector3 ahead = { -sinf(angle), -0.25f, cosf(angle) };
+        RecordFlythroughKey(path, loopTime*i/loopKeys, position, Vector3Add(position, ahead));
+    }
+
+    Vector3 start = path->keys[path->keyCount - 1].position;
+    Vector3 end = { 2.0f*center.x - start.x, start.y, 2.0f*center.z - start.z };
+    Vector3 direction = Vector3Normalize(Vector3Subtract(end, start));
+    direction.y = -0.25f;
+    RecordFlythroughKey(path, loopTime + 0.5f, start, Vector3Add(start, direction));
+    RecordFlythroughKey(path, duration, end, Vector3Add(end, direction));
+}
+
+float GetFlythroughDuration(const FlythroughPath* path)
+{
+    return (path->keyCount > 0) ? path->keys[path->keyCount - 1].time : 0.0f;
+}
+
+// Camera position and target at a time along the path, clamped to its ends
+void GetFlythroughCamera(const FlythroughPath* path, float time, Vector3* position, Vector3* target)
+{
+    if (path->keyCount == 0) return;
+
+    int next = 0;
+    while ((next < path->keyCount) && (path->keys[next].time <= time)) next++;
+
+    if (next == 0) next = 1;
+    if (next >= path->keyCount)
+    {
+        *position = path->keys[path->keyCount - 1].position;
+        *target = path->keys[path->keyCount - 1].target;
+        return;
+    }
+
+    const FlythroughKey* a = &path->keys[next - 1];
+    const FlythroughKey* b = &path->keys[next];
+    float span = b->time - a->time;
+    float t = (span > 0.0f) ? Clamp((time - a->time)/span, 0.0f, 1.0f) : 1.0f;
+    *position = Vector3Lerp(a->position, b->position, t);
+    *target = Vector3Lerp(a->target, b->target, t);
+}
+
+// Start a benchmark along a path, the caller moves the camera to GetBenchmarkCamera() every frame
+void StartBenchmark(const FlythroughPath* path)
+{
+    benchmarkPath = *path;
+    benchmarkState = BenchmarkWarmup;
+    benchmarkFrameCount = 0;
+    benchmarkWarmupFrames = 0;
+    benchmarkStartTime = GetTime();
+
+    // One frame per timestep of the path, plus the last key
+    benchmarkFrameCapacity = (int)(GetFlythroughDuration(path)/BENCHMARK_TIMESTEP) + 1;
+    benchmarkFrames = (BenchmarkFrame*)MemAlloc(benchmarkFrameCapacity*sizeof(BenchmarkFrame));
+}
+
+// Call first thing in a frame. worldReady tells whether the world around the camera has finished loading,
+// the recorded frames start with the first frame after that.
+void BeginBenchmarkFrame(bool worldReady)
+{
+    double now = GetTime();
+
+    if (benchmarkState == BenchmarkRunning)
+    {
+        // The previous frame ends here, after its buffer swap
+        if (benchmarkFrameCount > 0) benchmarkFrames[benchmarkFrameCount - 1].frameTime = (float)((now - benchmarkFrameStart)*1000.0);
+        if (benchmarkFrameCount == benchmarkFrameCapacity) benchmarkState = BenchmarkDone;
+    }
+    else if (benchmarkState == BenchmarkWarmup)
+    {
+        benchmarkWarmupFrames++;
+        if (worldReady || (now - benchmarkStartTime >= BENCHMARK_MAX_WARMUP_TIME))
+        {
+            if (!worldReady) TraceLog(LOG_WARNING, "BENCHMARK: World still loading after %i frames, starting anyway", benchmarkWarmupFrames);
+            benchmarkWarmupTime = now - benchmarkStartTime;
+            benchmarkState = BenchmarkRunning;
+        }
+    }
+
+    benchmarkFrameStart = now;
+}
+
+// Camera of the current benchmark frame: the start of the path while warming up, then one timestep further each frame
+void GetBenchmarkCamera(Vector3* position, Vector3* target)
+{
+    float time = (benchmarkState == BenchmarkRunning) ? benchmarkFrameCount*BENCHMARK_TIMESTEP : 0.0f;
+    GetFlythroughCamera(&benchmarkPath, time, position, target);
+}
+
+// Call right before EndDrawing() with the frame's counters, frameTime and cpuTime are filled in here
+void EndBenchmarkFrame(BenchmarkFrame frame)
+{
+    if ((benchmarkState != BenchmarkRunning) || (benchmarkFrameCount == benchmarkFrameCapacity)) return;
+
+    frame.cpuTime = (float)((GetTime() - benchmarkFrameStart)*1000.0);
+    frame.frameTime = 0.0f;
+    benchmarkFrames[benchmarkFrameCount++] = frame;
+}
+
+static int CompareBenchmarkTimes(const void* a, const void* b)
+{
+    float difference = *(const float*)a - *(const float*)b;
+    return (difference > 0.0f) - (difference < 0.0f);
+}
+
+// Value below which the given fraction of sorted values lie (nearest rank)
+static float GetPercentile(const float* sorted, int count, float fraction)
+{
+    int rank = (int)ceilf(fraction*count) - 1;
+    if (rank < 0) rank = 0;
+    return sorted[rank];
+}
+
+// Write the recorded frames to csvFileName and the summary to summaryFileName (also logged), then free them
+void SaveBenchmarkResults(const char* csvFileName, const char* summaryFileName)
+{
+    int count = benchmarkFrameCount;
+    if (count == 0) return;
+
+    FILE* csv = fopen(csvFileName, "w");
+    if (csv != NULL)
+    {
+        fprintf(csv, "frame,frame_ms,cpu_ms,sections_drawn,draw_calls,triangles,remeshes,vram_kb,camera_x,camera_y,camera_z\n");
+        for (int i = 0; i < count; i++)
+        {
+            const BenchmarkFrame* frame = &benchmarkFrames[i];
+            fprintf(csv, "%i,%.3f,%.3f,%i,%i,%i,%i,%i,%.2f,%.2f,%.2f\n", i, frame->frameTime, frame->cpuTime, frame->sectionsDrawn, frame->drawCalls,
+                frame->triangles, frame->remeshes, frame->vramKB, frame->position.x, frame->position.y, frame->position.z);
+        }
+        fclose(csv);
+    }
+    else TraceLog(LOG_WARNING, "BENCHMARK: [%s] Failed to write frame CSV", csvFileName);
+
+    float* frameTimes = (float*)MemAlloc(count*sizeof(float));
+    float* cpuTimes = (float*)MemAlloc(count*sizeof(float));
+    double frameSum = 0.0, cpuSum = 0.0, sectionSum = 0.0, drawCallSum = 0.0, triangleSum = 0.0;
+    int remeshes = 0, peakVramKB = 0;
+    for (int i = 0; i < count; i++)
+    {
+        frameTimes[i] = benchmarkFrames[i].frameTime;
+        cpuTimes[i] = benchmarkFrames[i].cpuTime;
+        frameSum += frameTimes[i];
+        cpuSum += cpuTimes[i];
+        sectionSum += benchmarkFrames[i].sectionsDrawn;
+        drawCallSum += benchmarkFrames[i].drawCalls;
+        triangleSum += benchmarkFrames[i].triangles;
+        remeshes += benchmarkFrames[i].remeshes;
+        if (benchmarkFrames[i].vramKB > peakVramKB) peakVramKB = benchmarkFrames[i].vramKB;
+    }
+    qsort(frameTimes, count, sizeof(float), CompareBenchmarkTimes);
+    qsort(cpuTimes, count, sizeof(float), CompareBenchmarkTimes);
+
+    char lines[5][256] = { 0 };
+    snprintf(lines[0], sizeof(lines[0]), "frames: %i (%.2f s of path, warmup %i frames, %.2f s)", count, GetFlythroughDuration(&benchmarkPath),
+        benchmarkWarmupFrames, benchmarkWarmupTime);
+    snprintf(lines[1], sizeof(lines[1]), "frame ms: avg %.3f, p50 %.3f, p95 %.3f, p99 %.3f, max %.3f", frameSum/count, GetPercentile(frameTimes, count, 0.5f),
+        GetPercentile(frameTimes, count, 0.95f), GetPercentile(frameTimes, count, 0.99f), frameTimes[count - 1]);
+    snprintf(lines[2], sizeof(lines[2]), "cpu ms: avg %.3f, p50 %.3f, p95 %.3f, p99 %.3f, max %.3f", cpuSum/count, GetPercentile(cpuTimes, count, 0.5f),
+        GetPercentile(cpuTimes, count, 0.95f), GetPercentile(cpuTimes, count, 0.99f), cpuTimes[count - 1]);
+    snprintf(lines[3], sizeof(lines[3]), "per frame: %.1f sections, %.1f draw calls, %.0f triangles", sectionSum/count, drawCallSum/count, triangleSum/count);
+    snprintf(lines[4], sizeof(lines[4]), "remeshes: %i total, peak chunk VRAM %i KB", remeshes, peakVramKB);
+
+    FILE* summary = fopen(summaryFileName, "w");
+    for (int i = 0; i < 5; i++)
+    {
+        TraceLog(LOG_INFO, "BENCHMARK: %s", lines[i]);
+        if (summary != NULL) fprintf(summary, "%s\n", lines[i]);
+    }
+    if (summary != NULL) fclose(summary);
+    else TraceLog(LOG_WARNING, "BENCHMARK: [%s] Failed to write summary", summaryFileName);
+
+    MemFree(frameTimes);
+    MemFree(cpuTimes);
+    MemFree(benchmarkFrames);
+    benchmarkFrames = NULL;
+    benchmarkFrameCount = 0;
+}
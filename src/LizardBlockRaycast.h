@@ -0,0 +1,176 @@
+/*******************************************************************************************
+*
+*   LizardBlockRaycast * Block picking and box collision straight against block data
+*
+*   RaycastBlocks() walks a ray through the block grid one block at a time (Amanatides & Woo,
+*   "A Fast Voxel Traversal Algorithm for Ray Tracing") and stops at the first solid block, so
+*   its cost only depends on the distance travelled, never on mesh triangles. MoveBoxThroughBlocks()
+*   sweeps a box one axis at a time and stops it against solid blocks, for walking cameras.
+*
+*   Both read blocks through a GetBlockCallback taking world block coordinates, so they work across
+*   chunk borders and with any block store. Positions are in world units, one unit per block. Whether
+*   a block stops them comes from its registered type (BlockTypeInfo.solid).
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+#include "raymath.h"
+#include "LizardBlockWorld.h"
+
+#include <math.h>                           // Required for: floorf(), fabsf(), INFINITY
+
+// Block type at a world block coordinate
+typedef unsigned char (*GetBlockCallback)(int x, int y, int z);
+
+// Result of a block raycast
+typedef struct {
+    bool hit;                               // Whether a solid block was found within the distance
+    int blockX, blockY, blockZ;             // Hit block, in world block coordinates
+    Vector3 normal;                         // Normal of the face the ray entered through, zero if it started inside the block
+    float distance;                         // Distance along the ray to the hit face
+    unsigned char type;                     // Type of the hit block
+} BlockRayHit;
+
+// Find the first solid block along a ray, up to maxDistance
+BlockRayHit RaycastBlocks(Ray ray, float maxDistance, GetBlockCallback getBlock)
+{
+    BlockRayHit result = { 0 };
+    Vector3 direction = Vector3Normalize(ray.direction);
+    if (Vector3Length(direction) == 0.0f) return result;
+
+    float position[3] = { ray.position.x, ray.position.y, ray.position.z };
+    float dir[3] = { direction.x, direction.y, direction.z };
+    int block[3] = { 0 };
+    int step[3] = { 0 };
+    float tMax[3] = { 0 };      // Distance along the ray to the next block border on each axis
+    float tDelta[3] = { 0 };    // Distance along the ray between block borders on each axis
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        block[axis] = (int)floorf(position[axis]);
+
+        if (dir[axis] > 0.0f)
+        {
+            step[axis] = 1;
+            tDelta[axis] = 1.0f/dir[axis];
+            tMax[axis] = (block[axis] + 1 - position[axis])*tDelta[axis];
+        }
+        else if (dir[axis] < 0.0f)
+        {
+            step[axis] = -1;
+            tDelta[axis] = -1.0f/dir[axis];
+            tMax[axis] = (position[axis] - block[axis])*tDelta[axis];
+        }
+        else
+        {
+            tDelta[axis] = INFINITY;
+            tMax[axis] = INFINITY;
+        }
+    }
+
+    float distance = 0.0f;
+    int enteredAxis = -1;
+
+    while (distance <= maxDistance)
+    {
+        unsigned char type = getBlock(block[0], block[1], block[2]);
+        if (blockTypes[type].solid)
+        {
+            result.hit = true;
+            result.blockX = block[0];
+            result.blockY = block[1];
+            result.blockZ = block[2];
+            result.distance = distance;
+            result.type = type;
+            if (enteredAxis == 0) result.normal.x = (float)-step[0];
+            else if (enteredAxis == 1) result.normal.y = (float)-step[1];
+            else if (enteredAxis == 2) result.normal.z = (float)-step[2];
+            break;
+        }
+
+        // Step into the neighbouring block whose border is closest along the ray
+        int axis = (tMax[0] < tMax[1])? ((tMax[0] < tMax[2])? 0 : 2) : ((tMax[1] < tMax[2])? 1 : 2);
+        block[axis] += step[axis];
+        distance = tMax[axis];
+        tMax[axis] += tDelta[axis];
+        enteredAxis = axis;
+    }
+
+    return result;
+}
+
+// Whether any block in a row of cells across two axes is solid, layer is the coordinate on the third axis
+static bool IsBlockLayerSolid(int axis, int layer, int minB, int maxB, int minC, int maxC, GetBlockCallback getBlock)
+{
+    int cell[3] = { 0 };
+    cell[axis] = layer;
+
+    for (int b = minB; b <= maxB; b++)
+    {
+        for (int c = minC; c <= maxC; c++)
+        {
+            cell[(axis + 1)%3] = b;
+            cell[(axis + 2)%3] = c;
+            if (blockTypes[getBlock(cell[0], cell[1], cell[2])].solid) return true;
+        }
+    }
+
+    return false;
+}
+
+// Move a box by motion, stopping it against solid blocks, returns the motion that was possible.
+// Axes are resolved one at a time, vertical first, so a box resting on the ground still slides along it.
+Vector3 MoveBoxThroughBlocks(BoundingBox box, Vector3 motion, GetBlockCallback getBlock)
+{
+    const float skin = 0.001f;              // Gap kept between the box and blocks, so touching is not overlapping
+    const int axisOrder[3] = { 1, 0, 2 };
+
+    float boxMin[3] = { box.min.x, box.min.y, box.min.z };
+    float boxMax[3] = { box.max.x, box.max.y, box.max.z };
+    float move[3] = { motion.x, motion.y, motion.z };
+
+    for (int i = 0; i < 3; i++)
+    {
+        int axis = axisOrder[i];
+        if (move[axis] == 0.0f) continue;
+
+        // Cells the box covers on the other two axes
+        int b = (axis + 1)%3;
+        int c = (axis + 2)%3;
+        int minB = (int)floorf(boxMin[b] + skin);
+        int maxB = (int)floorf(boxMax[b] - skin);
+        int minC = (int)floorf(boxMin[c] + skin);
+        int maxC = (int)floorf(boxMax[c] - skin);
+
+        // Walk the layers of cells the leading face sweeps through and stop in front of the first solid one
+        if (move[axis] > 0.0f)
+        {
+            int last = (int)floorf(boxMax[axis] + move[axis]);
+            for (int layer = (int)floorf(boxMax[axis] - skin) + 1; layer <= last; layer++)
+            {
+                if (!IsBlockLayerSolid(axis, layer, minB, maxB, minC, maxC, getBlock)) continue;
+
+                move[axis] = fmaxf(layer - boxMax[axis] - skin, 0.0f);
+                break;
+            }
+        }
+        else
+        {
+            int last = (int)floorf(boxMin[axis] + move[axis]);
+            for (int layer = (int)floorf(boxMin[axis] + skin) - 1; layer >= last; layer--)
+            {
+                if (!IsBlockLayerSolid(axis, layer, minB, maxB, minC, maxC, getBlock)) continue;
+
+                move[axis] = fminf(layer + 1 - boxMin[axis] + skin, 0.0f);
+                break;
+            }
+        }
+
+        boxMin[axis] += move[axis];
+        boxMax[axis] += move[axis];
+    }
+
+    return (Vector3){ move[0], move[1], move[2] };
+}
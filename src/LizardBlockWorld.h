@@ -0,0 +1,360 @@
+/*******************************************************************************************
+*
+*   LizardBlockWorld * Block types and compact per-chunk block storage
+*
+*   A chunk's blocks are kept in the smallest of three representations:
+*     - Single:  every block has the same type (all-air sky, all-stone deep chunks), no data
+*     - Palette: up to 16 distinct types, 1/2/4 bit indices into a per-chunk palette
+*     - Direct:  one byte per block
+*   EncodeBlockStorage() picks the representation from a full byte array, GetBlockType() reads
+*   one block and DecodeBlockStorage() expands a whole chunk for tight loops like the mesher.
+*   GetBlockStorageConnections() flood fills a chunk's air to find which of its faces see each other.
+*
+*   What a block type looks like and how it behaves comes from the block registry: InitBlockTypes()
+*   registers the built-in BlockType values, RegisterBlockType() adds more at runtime. Both fill
+*   blockFaceVisible, so meshers decide whether a face is drawn with one table read.
+*
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+
+#include <string.h>                         // Required for: memset(), memcpy(), memcmp()
+
+//Chunk definitions
+#define CHUNK_SIZE 16  // Chunk size: 16x16x16 blocks
+#define BLOCK_SIZE 1.0f // Each block is 1x1x1 units
+#define CHUNK_VOLUME (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE)
+#define CHUNK_SECTIONS 8 // Sections stacked in a chunk column
+#define WORLD_HEIGHT (CHUNK_SECTIONS * CHUNK_SIZE) // World height, in blocks
+// Index of block (x, y, z) in a chunk sized byte array, z is contiguous
+#define BLOCK_INDEX(x, y, z) ((((x) * CHUNK_SIZE) + (y)) * CHUNK_SIZE + (z))
+// Chunk plus a one block border taken from its neighbours, coordinates -1..CHUNK_SIZE
+#define PADDED_CHUNK_SIZE (CHUNK_SIZE + 2)
+#define PADDED_CHUNK_VOLUME (PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE)
+#define PADDED_BLOCK_INDEX(x, y, z) (((((x) + 1) * PADDED_CHUNK_SIZE) + ((y) + 1)) * PADDED_CHUNK_SIZE + ((z) + 1))
+
+#define MAX_BLOCK_PALETTE 16
+#define MAX_BLOCK_TYPES 64 // Registered block types, built-in ones included
+#define MAX_BLOCK_TEXTURES 64 // Distinct face textures of all block types
+
+// Built-in block types, registered in this order by InitBlockTypes()
+enum BlockType
+{
+    Air,
+    Dirt,
+    Grass,
+    Stone,
+    Sand,
+    Water,
+    Lamp,
+    BlockTypeCount // Use this to keep track of the number of built-in block types
+};
+
+// Texture of a block face: a tile of the block tile image (row major) multiplied by a tint
+typedef struct {
+    int tile;
+    Color tint;
+} BlockTexture;
+
+// Registered block type
+typedef struct {
+    const char* name;
+    bool visible;                           // Has faces to draw
+    bool solid;                             // Stops block picking and the walking camera
+    bool opaque;                            // Hides the faces of its neighbours and blocks sight for occlusion culling
+    BlockTexture faces[6];                  // Per face, -x, +x, -y, +y, -z, +z
+    unsigned char emission;                 // Block light it gives off, 0..15
+    unsigned char faceTextures[6];          // Index of each face in blockTextures, set when registered
+} BlockTypeInfo;
+
+BlockTypeInfo blockTypes[MAX_BLOCK_TYPES] = { 0 };
+int blockTypeCount = 0;
+BlockTexture blockTextures[MAX_BLOCK_TEXTURES] = { 0 };
+int blockTextureCount = 0;
+// [type][neighbour] whether a face of type is drawn against the neighbour across it
+unsigned char blockFaceVisible[MAX_BLOCK_TYPES][MAX_BLOCK_TYPES] = { 0 };
+
+// Add a block type, returns its type or -1 if the registry or texture list is full. Main thread only, before any
+// chunk using the type is meshed.
+int RegisterBlockType(BlockTypeInfo info)
+{
+    if (blockTypeCount == MAX_BLOCK_TYPES) return -1;
+
+    // Share textures between faces and types
+    for (int f = 0; f < 6; f++)
+    {
+        BlockTexture texture = info.faces[f];
+        int index = 0;
+        while (index < blockTextureCount && (blockTextures[index].tile != texture.tile || memcmp(&blockTextures[index].tint, &texture.tint, sizeof(Color)) != 0)) index++;
+
+        if (index == blockTextureCount)
+        {
+            if (!info.visible) index = 0;
+            else if (blockTextureCount == MAX_BLOCK_TEXTURES) return -1;
+            else blockTextures[blockTextureCount++] = texture;
+        }
+        info.faceTextures[f] = (unsigned char)index;
+    }
+
+    int type = blockTypeCount++;
+    blockTypes[type] = info;
+
+    // A face shows unless the neighbour is opaque, faces between blocks of the same type are never drawn
+    for (int other = 0; other < blockTypeCount; other++)
+    {
+        blockFaceVisible[type][other] = info.visible && !blockTypes[other].opaque && (other != type);
+        blockFaceVisible[other][type] = blockTypes[other].visible && !info.opaque && (other != type);
+    }
+
+    return type;
+}
+
+// Register the built-in block types, the values of enum BlockType
+void InitBlockTypes(void)
+{
+    const Color sand = { 230, 210, 150, 255 };
+    const Color water = { 70, 120, 220, 255 };
+    const Color grass = { 110, 190, 80, 255 };
+    const Color lamp = { 255, 225, 140, 255 };
+    const BlockTexture dirtSide = { 1, WHITE };
+
+    const BlockTypeInfo builtIn[BlockTypeCount] = {
+        { "air", false, false, false },
+        { "dirt", true, true, true, { dirtSide, dirtSide, dirtSide, dirtSide, dirtSide, dirtSide } },
+        { "grass", true, true, true, { dirtSide, dirtSide, dirtSide, { 2, grass }, dirtSide, dirtSide } },
+        { "stone", true, true, true, { { 3, WHITE }, { 3, WHITE }, { 3, WHITE }, { 3, WHITE }, { 3, WHITE }, { 3, WHITE } } },
+        { "sand", true, true, true, { { 2, sand }, { 2, sand }, { 2, sand }, { 2, sand }, { 2, sand }, { 2, sand } } },
+        { "water", true, false, false, { { 2, water }, { 2, water }, { 2, water }, { 2, water }, { 2, water }, { 2, water } } },
+        { "lamp", true, true, true, { { 0, lamp }, { 0, lamp }, { 0, lamp }, { 0, lamp }, { 0, lamp }, { 0, lamp } }, 14 },
+    };
+
+    blockTypeCount = 0;
+    blockTextureCount = 0;
+    for (int i = 0; i < BlockTypeCount; i++) RegisterBlockType(builtIn[i]);
+}
+
+enum BlockStorageMode
+{
+    BlockStorageSingle,
+    BlockStoragePalette,
+    BlockStorageDirect,
+};
+
+typedef struct {
+    int mode;
+    unsigned char singleType;                   // Type of every block in single mode
+    unsigned char palette[MAX_BLOCK_PALETTE];   // Palette mode: index -> block type
+    int paletteCount;
+    int bitsPerIndex;                           // Palette mode: 1, 2 or 4
+    unsigned char* data;                        // Packed palette indices or one byte per block
+} BlockStorage;
+
+// Bytes used by a storage's block data
+int GetBlockStorageSize(const BlockStorage* storage)
+{
+    if (storage->mode == BlockStoragePalette) return CHUNK_VOLUME * storage->bitsPerIndex / 8;
+    if (storage->mode == BlockStorageDirect) return CHUNK_VOLUME;
+    return 0;
+}
+
+void FreeBlockStorage(BlockStorage* storage)
+{
+    if (storage->data != NULL) MemFree(storage->data);
+    *storage = (BlockStorage){ 0 };
+}
+
+// Read the type of block (x, y, z), coordinates must be inside the chunk
+static inline unsigned char GetBlockType(const BlockStorage* storage, int x, int y, int z)
+{
+    int index = BLOCK_INDEX(x, y, z);
+
+    switch (storage->mode)
+    {
+        case BlockStorageDirect: return storage->data[index];
+        case BlockStoragePalette:
+        {
+            int bit = index * storage->bitsPerIndex;
+            int paletteIndex = (storage->data[bit >> 3] >> (bit & 7)) & ((1 << storage->bitsPerIndex) - 1);
+            return storage->palette[paletteIndex];
+        }
+        default: return storage->singleType;
+    }
+}
+
+// Expand every block of a storage into a CHUNK_VOLUME byte array indexed with BLOCK_INDEX
+void DecodeBlockStorage(const BlockStorage* storage, unsigned char* types)
+{
+    switch (storage->mode)
+    {
+        case BlockStorageDirect: memcpy(types, storage->data, CHUNK_VOLUME); break;
+        case BlockStoragePalette:
+        {
+            int bits = storage->bitsPerIndex;
+            int indicesPerByte = 8 / bits;
+            int mask = (1 << bits) - 1;
+
+            for (int i = 0; i < CHUNK_VOLUME / indicesPerByte; i++)
+            {
+                unsigned char packed = storage->data[i];
+                for (int j = 0; j < indicesPerByte; j++) types[i * indicesPerByte + j] = storage->palette[(packed >> (j * bits)) & mask];
+            }
+        } break;
+        default: memset(types, storage->singleType, CHUNK_VOLUME); break;
+    }
+}
+
+// Replace a storage's contents with a CHUNK_VOLUME byte array, using the smallest representation
+void EncodeBlockStorage(BlockStorage* storage, const unsigned char* types)
+{
+    // Build the palette, map block type -> palette index
+    int paletteIndex[256];
+    unsigned char palette[MAX_BLOCK_PALETTE];
+    int paletteCount = 0;
+    bool tooManyTypes = false;
+
+    for (int i = 0; i < 256; i++) paletteIndex[i] = -1;
+
+    for (int i = 0; i < CHUNK_VOLUME; i++)
+    {
+        unsigned char type = types[i];
+        if (paletteIndex[type] != -1) continue;
+
+        if (paletteCount == MAX_BLOCK_PALETTE)
+        {
+            tooManyTypes = true;
+            break;
+        }
+        paletteIndex[type] = paletteCount;
+        palette[paletteCount++] = type;
+    }
+
+    FreeBlockStorage(storage);
+
+    if (tooManyTypes)
+    {
+        storage->mode = BlockStorageDirect;
+        storage->data = (unsigned char*)MemAlloc(CHUNK_VOLUME);
+        memcpy(storage->data, types, CHUNK_VOLUME);
+    }
+    else if (paletteCount == 1)
+    {
+        storage->mode = BlockStorageSingle;
+        storage->singleType = palette[0];
+    }
+    else
+    {
+        int bits = (paletteCount <= 2) ? 1 : (paletteCount <= 4) ? 2 : 4;
+
+        storage->mode = BlockStoragePalette;
+        storage->bitsPerIndex = bits;
+        storage->paletteCount = paletteCount;
+        memcpy(storage->palette, palette, paletteCount);
+        storage->data = (unsigned char*)MemAlloc(CHUNK_VOLUME * bits / 8);
+
+        for (int i = 0; i < CHUNK_VOLUME; i++)
+        {
+            int bit = i * bits;
+            storage->data[bit >> 3] |= (unsigned char)(paletteIndex[types[i]] << (bit & 7));
+        }
+    }
+}
+
+// Write the type of block (x, y, z), re-encoding the storage when the type does not fit the current representation
+void SetBlockType(BlockStorage* storage, int x, int y, int z, unsigned char type)
+{
+    int index = BLOCK_INDEX(x, y, z);
+
+    if (storage->mode == BlockStorageDirect)
+    {
+        storage->data[index] = type;
+        return;
+    }
+
+    if (storage->mode == BlockStoragePalette)
+    {
+        for (int i = 0; i < storage->paletteCount; i++)
+        {
+            if (storage->palette[i] != type) continue;
+
+            int bit = index * storage->bitsPerIndex;
+            int mask = ((1 << storage->bitsPerIndex) - 1) << (bit & 7);
+            storage->data[bit >> 3] = (unsigned char)((storage->data[bit >> 3] & ~mask) | (i << (bit & 7)));
+            return;
+        }
+    }
+    else if (storage->singleType == type) return;
+
+    // New type for this chunk: expand, write and pick a new representation
+    unsigned char types[CHUNK_VOLUME];
+    DecodeBlockStorage(storage, types);
+    types[index] = type;
+    EncodeBlockStorage(storage, types);
+}
+
+// Find which faces of a section can see each other through non-opaque blocks, for occlusion culling. Faces are in
+// the order -x, +x, -y, +y, -z, +z and connections[a] gets bit b set when such a path joins face a to face b.
+void GetBlockStorageConnections(const BlockStorage* storage, unsigned char connections[6])
+{
+    memset(connections, 0, 6);
+
+    if (storage->mode == BlockStorageSingle)
+    {
+        if (!blockTypes[storage->singleType].opaque) memset(connections, 0x3f, 6);
+        return;
+    }
+
+    unsigned char types[CHUNK_VOLUME];
+    unsigned char visited[CHUNK_VOLUME] = { 0 };
+    unsigned short queue[CHUNK_VOLUME];
+    DecodeBlockStorage(storage, types);
+
+    // Flood fill every region of see-through blocks once and join all the faces it touches
+    for (int start = 0; start < CHUNK_VOLUME; start++)
+    {
+        if (blockTypes[types[start]].opaque || visited[start]) continue;
+
+        int head = 0;
+        int tail = 0;
+        int faces = 0;
+        queue[tail++] = (unsigned short)start;
+        visited[start] = 1;
+
+        while (head < tail)
+        {
+            int index = queue[head++];
+            int x = index/(CHUNK_SIZE*CHUNK_SIZE);
+            int y = (index/CHUNK_SIZE)%CHUNK_SIZE;
+            int z = index%CHUNK_SIZE;
+
+            if (x == 0) faces |= 1 << 0;
+            if (x == CHUNK_SIZE - 1) faces |= 1 << 1;
+            if (y == 0) faces |= 1 << 2;
+            if (y == CHUNK_SIZE - 1) faces |= 1 << 3;
+            if (z == 0) faces |= 1 << 4;
+            if (z == CHUNK_SIZE - 1) faces |= 1 << 5;
+
+            int neighbours[6] = {
+                (x > 0)? index - CHUNK_SIZE*CHUNK_SIZE : -1, (x < CHUNK_SIZE - 1)? index + CHUNK_SIZE*CHUNK_SIZE : -1,
+                (y > 0)? index - CHUNK_SIZE : -1, (y < CHUNK_SIZE - 1)? index + CHUNK_SIZE : -1,
+                (z > 0)? index - 1 : -1, (z < CHUNK_SIZE - 1)? index + 1 : -1
+            };
+
+            for (int i = 0; i < 6; i++)
+            {
+                int next = neighbours[i];
+                if ((next < 0) || visited[next] || blockTypes[types[next]].opaque) continue;
+
+                visited[next] = 1;
+                queue[tail++] = (unsigned short)next;
+            }
+        }
+
+        for (int face = 0; face < 6; face++)
+        {
+            if (faces & (1 << face)) connections[face] |= (unsigned char)faces;
+        }
+    }
+}
@@ -0,0 +1,387 @@
+/*******************************************************************************************
+*
+*   LizardChunkMesh * CPU side chunk meshing
+*
+*   Turns a padded section (the section's blocks plus a one block border from its neighbours,
+*   see PadChunkSection()) into packed ChunkVertex quads, either one quad per exposed face or
+*   greedily merged rectangles. No GL calls, meshes are uploaded by the caller.
+*
+*   Distant sections are meshed at a lower level of detail: PadChunkSection() downsamples the
+*   blocks into cells of 2, 4 or 8 blocks and the greedy mesher merges each cell into big quads.
+*
+*   Every vertex carries smooth light (the average of the see-through blocks around its corner) and
+*   ambient occlusion, read from a padded light array next to the padded blocks. The greedy mesher
+*   only merges faces whose four corners are lit and occluded the same.
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+#include "LizardBlockWorld.h"
+#include "LizardJobs.h"                     // Required for: GetJobScratch()
+#include "LizardLight.h"                    // Required for: FULL_SKY_LIGHT, LIGHT_SKY(), LIGHT_BLOCK()
+
+#include <string.h>                         // Required for: memset(), memcpy()
+
+// Block atlas definitions: every texture in blockTextures gets a cell, its tile with half a tile of wrapped border
+// on each side so bilinear filtering and mipmaps never reach the next cell
+#define BLOCK_TILE_SIZE 32 // Size of a tile in the block tile image, in pixels
+#define BLOCK_ATLAS_CELL_SIZE (BLOCK_TILE_SIZE * 2)
+#define BLOCK_ATLAS_COLUMNS 8 // Cells in an atlas row
+#define MAX_CHUNK_LOD 3 // Coarsest level of detail, cells of 1 << MAX_CHUNK_LOD blocks
+// Chunk meshing modes
+enum MeshingMode
+{
+    MeshingNaive,  // One quad per exposed block face
+    MeshingGreedy, // Coplanar faces of the same block type merged into rectangles
+};
+// Packed chunk vertex, 8 bytes. lizard.vs rebuilds the texture coordinates from the position and face.
+typedef struct {
+    unsigned char x, y, z;          // Chunk local position, in blocks (0..CHUNK_SIZE)
+    unsigned char face;             // Index into faceDirections
+    unsigned char tileX, tileY;     // Atlas cell column and row
+    unsigned char light;            // Sky light << 4 | block light around the corner
+    unsigned char ao;               // Ambient occlusion of the corner, 0 (open) to 3
+} ChunkVertex;
+// Vertex data filled by the meshers, 4 vertices per quad drawn with 0-1-2-0-2-3 indices
+typedef struct {
+    ChunkVertex* vertices;
+    int vertexCount;
+} ChunkMeshBuilder;
+// Face directions in the order the mesher emits them. Each face spans two axes (0 = x, 1 = y, 2 = z)
+// which also drive the texture u/v, and flip reverses the corner order so every face stays counter-clockwise
+// when seen from outside the block with the shared 0-1-2-0-2-3 quad indices.
+typedef struct {
+    int dx, dy, dz; // Face normal, also the offset of the neighbour that hides this face
+    int uAxis;      // Axis along the quad width and texture u
+    int vAxis;      // Axis along the quad height and texture v
+    bool flip;      // Reverse the corner order
+} FaceDirection;
+static const FaceDirection faceDirections[6] = {
+    { -1, 0, 0, 2, 1, false }, // Left face (west) - negative X direction
+    { 1, 0, 0, 2, 1, true },   // Right face (east) - positive X direction
+    { 0, -1, 0, 0, 2, false }, // Bottom face - negative Y direction
+    { 0, 1, 0, 2, 0, false },  // Top face - positive Y direction
+    { 0, 0, -1, 0, 1, true },  // Front face (north) - negative Z direction
+    { 0, 0, 1, 0, 1, false },  // Back face (south) - positive Z direction
+};
+// Add a quad of width x height blocks starting at block (x, y, z) for the given face, light and ao are per corner
+void PushChunkQuad(ChunkMeshBuilder* builder, int faceIndex, int x, int y, int z, int width, int height, int blockType,
+    const unsigned char light[4], const unsigned char ao[4]) {
+    const FaceDirection* face = &faceDirections[faceIndex];
+    int origin[3] = { x, y, z };
+
+    // Positive faces sit on the far side of the block
+    if (face->dx + face->dy + face->dz > 0) {
+        int normalAxis = (face->dx != 0) ? 0 : (face->dy != 0) ? 1 : 2;
+        origin[normalAxis] += 1;
+    }
+
+    int corners[4][3];
+    for (int i = 0; i < 4; i++) {
+        corners[i][0] = origin[0];
+        corners[i][1] = origin[1];
+        corners[i][2] = origin[2];
+    }
+    corners[1][face->uAxis] += width;
+    corners[2][face->uAxis] += width;
+    corners[2][face->vAxis] += height;
+    corners[3][face->vAxis] += height;
+
+    int texture = blockTypes[blockType].faceTextures[faceIndex];
+
+    // Split the quad along the diagonal between its less occluded corners, so occlusion interpolates evenly
+    int start = (ao[0] + ao[2] > ao[1] + ao[3]) ? 1 : 0;
+
+    // Flipped faces emit base, +V, +U+V, +U so the shared indices wind them the other way
+    ChunkVertex* vertices = &builder->vertices[builder->vertexCount];
+    for (int i = 0; i < 4; i++) {
+        int corner = (face->flip ? (4 - i) % 4 : i);
+        corner = (corner + (face->flip ? 4 - start : start)) % 4;
+        ChunkVertex* vertex = &vertices[i];
+        vertex->x = (unsigned char)corners[corner][0];
+        vertex->y = (unsigned char)corners[corner][1];
+        vertex->z = (unsigned char)corners[corner][2];
+        vertex->face = (unsigned char)faceIndex;
+        vertex->tileX = (unsigned char)(texture % BLOCK_ATLAS_COLUMNS);
+        vertex->tileY = (unsigned char)(texture / BLOCK_ATLAS_COLUMNS);
+        vertex->light = light[corner];
+        vertex->ao = ao[corner];
+    }
+
+    builder->vertexCount += 4;
+}
+// Whether every block of a storage has the same opaque type
+static inline bool IsBlockStorageOpaque(const BlockStorage* storage) {
+    return storage->mode == BlockStorageSingle && blockTypes[storage->singleType].opaque;
+}
+// Type of the cellSize^3 cell starting at block (x, y, z) of a CHUNK_VOLUME array: air unless at least half
+// of it is visible blocks, otherwise the type of its highest visible block so surfaces keep their top layer
+static unsigned char GetCellType(const unsigned char* types, int x, int y, int z, int cellSize) {
+    if (cellSize == 1) return types[BLOCK_INDEX(x, y, z)];
+
+    int solidCount = 0;
+    int topY = -1;
+    unsigned char topType = Air;
+    for (int i = 0; i < cellSize; i++) {
+        for (int j = 0; j < cellSize; j++) {
+            for (int k = 0; k < cellSize; k++) {
+                unsigned char type = types[BLOCK_INDEX(x + i, y + j, z + k)];
+                if (!blockTypes[type].visible) continue;
+
+                solidCount++;
+                if (y + j > topY) {
+                    topY = y + j;
+                    topType = type;
+                }
+            }
+        }
+    }
+
+    return (solidCount * 2 >= cellSize * cellSize * cellSize) ? topType : Air;
+}
+// Function to copy a section's blocks plus a one block border from its neighbours into a PADDED_CHUNK_VOLUME
+// array for the meshers. neighbours are in faceDirections order (-x, +x, -y, +y, -z, +z), NULL ones are air.
+// With lod > 0 every cell of 1 << lod blocks (and the neighbour cells along the border) is filled with its
+// GetCellType(), so the greedy mesher turns each cell into merged quads.
+void PadChunkSection(const BlockStorage* blocks, const BlockStorage* neighbours[6], int lod, unsigned char* padded) {
+    int cellSize = 1 << lod;
+    unsigned char types[CHUNK_VOLUME];
+    DecodeBlockStorage(blocks, types);
+
+    memset(padded, Air, PADDED_CHUNK_VOLUME);
+    if (lod == 0) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            for (int y = 0; y < CHUNK_SIZE; y++) memcpy(&padded[PADDED_BLOCK_INDEX(x, y, 0)], &types[BLOCK_INDEX(x, y, 0)], CHUNK_SIZE);
+        }
+    }
+    else {
+        for (int x = 0; x < CHUNK_SIZE; x += cellSize) {
+            for (int y = 0; y < CHUNK_SIZE; y += cellSize) {
+                for (int z = 0; z < CHUNK_SIZE; z += cellSize) {
+                    unsigned char type = GetCellType(types, x, y, z, cellSize);
+                    if (type == Air) continue;
+
+                    for (int i = 0; i < cellSize; i++) {
+                        for (int j = 0; j < cellSize; j++) memset(&padded[PADDED_BLOCK_INDEX(x + i, y + j, z)], type, cellSize);
+                    }
+                }
+            }
+        }
+    }
+
+    for (int f = 0; f < 6; f++) {
+        if (neighbours[f] == NULL) continue;
+
+        const FaceDirection* face = &faceDirections[f];
+        int normalAxis = (face->dx != 0) ? 0 : (face->dy != 0) ? 1 : 2;
+        bool negative = (face->dx + face->dy + face->dz < 0);
+
+        // Border layer in this section's coordinates and the matching layer of cells inside the neighbour
+        int border = negative ? -1 : CHUNK_SIZE;
+        int source = negative ? CHUNK_SIZE - cellSize : 0;
+
+        DecodeBlockStorage(neighbours[f], types);
+
+        for (int v = 0; v < CHUNK_SIZE; v += cellSize) {
+            for (int u = 0; u < CHUNK_SIZE; u += cellSize) {
+                int pos[3];
+                pos[normalAxis] = source;
+                pos[face->uAxis] = u;
+                pos[face->vAxis] = v;
+                unsigned char type = GetCellType(types, pos[0], pos[1], pos[2], cellSize);
+                if (type == Air) continue;
+
+                pos[normalAxis] = border;
+                for (int j = 0; j < cellSize; j++) {
+                    for (int i = 0; i < cellSize; i++) {
+                        pos[face->uAxis] = u + i;
+                        pos[face->vAxis] = v + j;
+                        padded[PADDED_BLOCK_INDEX(pos[0], pos[1], pos[2])] = type;
+                    }
+                }
+            }
+        }
+    }
+}
+// Whether a section has no visible faces: it and all six neighbours are completely opaque
+bool IsChunkSectionBuried(const BlockStorage* blocks, const BlockStorage* neighbours[6]) {
+    if (!IsBlockStorageOpaque(blocks)) return false;
+    for (int f = 0; f < 6; f++) {
+        if (neighbours[f] == NULL || !IsBlockStorageOpaque(neighbours[f])) return false;
+    }
+    return true;
+}
+// Whether the face of block (x, y, z) of a padded chunk in direction f is drawn, see blockFaceVisible
+static inline bool IsFaceVisible(const unsigned char* types, int type, int x, int y, int z, int f) {
+    const FaceDirection* face = &faceDirections[f];
+    return blockFaceVisible[type][types[PADDED_BLOCK_INDEX(x + face->dx, y + face->dy, z + face->dz)]];
+}
+// Smooth light and ambient occlusion of the four corners of the face of block (x, y, z) in direction f, in
+// PushChunkQuad() corner order. Each corner looks at the block in front of the face and the two side blocks and
+// the diagonal block next to it in the front layer: occlusion counts the opaque ones, light averages the others.
+// Without light data everything is open sky.
+static void GetFaceCorners(const unsigned char* types, const unsigned char* light, int x, int y, int z, int f,
+    unsigned char cornerLight[4], unsigned char cornerAo[4]) {
+    if (light == NULL) {
+        memset(cornerLight, FULL_SKY_LIGHT, 4);
+        memset(cornerAo, 0, 4);
+        return;
+    }
+
+    static const int cornerSigns[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+    const FaceDirection* face = &faceDirections[f];
+    int front[3] = { x + face->dx, y + face->dy, z + face->dz };
+    unsigned char frontLight = light[PADDED_BLOCK_INDEX(front[0], front[1], front[2])];
+
+    for (int c = 0; c < 4; c++) {
+        int offsets[3][2] = { { cornerSigns[c][0], 0 }, { 0, cornerSigns[c][1] }, { cornerSigns[c][0], cornerSigns[c][1] } };
+        bool opaque[3];
+        int sky = LIGHT_SKY(frontLight), block = LIGHT_BLOCK(frontLight), samples = 1;
+
+        for (int i = 0; i < 3; i++) {
+            int pos[3] = { front[0], front[1], front[2] };
+            pos[face->uAxis] += offsets[i][0];
+            pos[face->vAxis] += offsets[i][1];
+            int index = PADDED_BLOCK_INDEX(pos[0], pos[1], pos[2]);
+            opaque[i] = blockTypes[types[index]].opaque;
+
+            // Light does not leak through the diagonal when both sides close it off
+            if (opaque[i] || (i == 2 && opaque[0] && opaque[1])) continue;
+            sky += LIGHT_SKY(light[index]);
+            block += LIGHT_BLOCK(light[index]);
+            samples++;
+        }
+
+        cornerAo[c] = (opaque[0] && opaque[1]) ? 3 : (unsigned char)(opaque[0] + opaque[1] + opaque[2]);
+        cornerLight[c] = (unsigned char)((((sky + samples/2) / samples) << 4) | ((block + samples/2) / samples));
+    }
+}
+// Naive mesher: one quad per exposed block face
+void BuildChunkMeshNaive(const unsigned char* types, const unsigned char* light, ChunkMeshBuilder* builder) {
+    unsigned char cornerLight[4], cornerAo[4];
+
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            for (int z = 0; z < CHUNK_SIZE; z++) {
+                int type = types[PADDED_BLOCK_INDEX(x, y, z)];
+
+                if (!blockTypes[type].visible) continue;  // Only process blocks with faces
+
+                for (int f = 0; f < 6; f++) {
+                    if (!IsFaceVisible(types, type, x, y, z, f)) continue;
+                    GetFaceCorners(types, light, x, y, z, f, cornerLight, cornerAo);
+                    PushChunkQuad(builder, f, x, y, z, 1, 1, type, cornerLight, cornerAo);
+                }
+            }
+        }
+    }
+}
+// Greedy mesher: for every face direction and slice, build a mask of exposed faces and merge
+// runs of the same block type into maximal rectangles, first along u and then along v.
+// Faces only merge when their corners all share one light and occlusion value, the rest stay single quads.
+#define GREEDY_NO_MERGE (1 << 24) // Mask flag of a face with differing corners
+void BuildChunkMeshGreedy(const unsigned char* types, const unsigned char* light, ChunkMeshBuilder* builder) {
+    int mask[CHUNK_SIZE][CHUNK_SIZE]; // [v][u] block type | light << 8 | ao << 16 of the exposed face, Air if none
+    unsigned char cornerLight[4], cornerAo[4];
+
+    for (int f = 0; f < 6; f++) {
+        const FaceDirection* face = &faceDirections[f];
+        int normalAxis = (face->dx != 0) ? 0 : (face->dy != 0) ? 1 : 2;
+
+        for (int slice = 0; slice < CHUNK_SIZE; slice++) {
+            // Fill the mask for this slice
+            for (int v = 0; v < CHUNK_SIZE; v++) {
+                for (int u = 0; u < CHUNK_SIZE; u++) {
+                    int pos[3];
+                    pos[normalAxis] = slice;
+                    pos[face->uAxis] = u;
+                    pos[face->vAxis] = v;
+
+                    int type = types[PADDED_BLOCK_INDEX(pos[0], pos[1], pos[2])];
+                    if (!IsFaceVisible(types, type, pos[0], pos[1], pos[2], f)) {
+                        mask[v][u] = Air;
+                        continue;
+                    }
+
+                    GetFaceCorners(types, light, pos[0], pos[1], pos[2], f, cornerLight, cornerAo);
+                    bool uniform = true;
+                    for (int c = 1; c < 4; c++) {
+                        if (cornerLight[c] != cornerLight[0] || cornerAo[c] != cornerAo[0]) uniform = false;
+                    }
+                    mask[v][u] = uniform ? (type | (cornerLight[0] << 8) | (cornerAo[0] << 16)) : (type | GREEDY_NO_MERGE);
+                }
+            }
+
+            // Merge the mask into rectangles
+            for (int v = 0; v < CHUNK_SIZE; v++) {
+                for (int u = 0; u < CHUNK_SIZE; ) {
+                    int type = mask[v][u];
+                    if (type == Air) {
+                        u++;
+                        continue;
+                    }
+
+                    int width = 1;
+                    int height = 1;
+                    bool canGrow = !(type & GREEDY_NO_MERGE);
+                    while (canGrow && u + width < CHUNK_SIZE && mask[v][u + width] == type) width++;
+
+                    while (v + height < CHUNK_SIZE && canGrow) {
+                        for (int k = 0; k < width; k++) {
+                            if (mask[v + height][u + k] != type) {
+                                canGrow = false;
+                                break;
+                            }
+                        }
+                        if (canGrow) height++;
+                    }
+
+                    int pos[3];
+                    pos[normalAxis] = slice;
+                    pos[face->uAxis] = u;
+                    pos[face->vAxis] = v;
+                    if (type & GREEDY_NO_MERGE) {
+                        GetFaceCorners(types, light, pos[0], pos[1], pos[2], f, cornerLight, cornerAo);
+                    } else {
+                        memset(cornerLight, (type >> 8) & 0xff, 4);
+                        memset(cornerAo, (type >> 16) & 0xff, 4);
+                    }
+                    PushChunkQuad(builder, f, pos[0], pos[1], pos[2], width, height, type & 0xff, cornerLight, cornerAo);
+
+                    // Clear the merged area so it is not emitted again
+                    for (int j = 0; j < height; j++) {
+                        for (int k = 0; k < width; k++) mask[v + j][u + k] = Air;
+                    }
+                    u += width;
+                }
+            }
+        }
+    }
+}
+// Build the CPU side mesh of a padded section (see PadChunkSection) with the given MeshingMode, light is the
+// matching padded light array or NULL for full sky light and no occlusion (lower levels of detail).
+// Safe to call from worker threads
+void BuildChunkMesh(const unsigned char* types, const unsigned char* light, int mode, ChunkMeshBuilder* builder) {
+
+    // Max number of vertices for all blocks in the chunk (6 faces per block)
+    const int maxVertices = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 6 * 4;
+
+    *builder = (ChunkMeshBuilder){ 0 };
+
+    // Mesh into the thread's worst case scratch buffer, allocated once per thread
+    builder->vertices = (ChunkVertex*)GetJobScratch(maxVertices * sizeof(ChunkVertex));
+
+    if (mode == MeshingGreedy) BuildChunkMeshGreedy(types, light, builder);
+    else BuildChunkMeshNaive(types, light, builder);
+
+    // Keep only the vertices written, the scratch buffer is reused by the thread's next job
+    if (builder->vertexCount == 0) {
+        builder->vertices = NULL;
+        return;
+    }
+    ChunkVertex* vertices = (ChunkVertex*)MemAlloc(builder->vertexCount * sizeof(ChunkVertex));
+    memcpy(vertices, builder->vertices, builder->vertexCount * sizeof(ChunkVertex));
+    builder->vertices = vertices;
+}
@@ -0,0 +1,351 @@
+/*******************************************************************************************
+*
+*   LizardJobs * Fixed pool of worker threads for background work
+*
+*   A job is a work function that runs on a worker thread plus an optional completion
+*   function that runs later on the main (GL) thread from RunJobCompletions(), which is
+*   where GPU uploads belong. The pool uses Win32 threads with MSVC, and pthreads on other
+*   desktop compilers and on web builds made with Emscripten pthreads (-pthread). Without
+*   thread support (single threaded web builds) ScheduleJob() runs the work function
+*   immediately and only the completion is deferred, so callers behave the same either way.
+*
+*   Every thread also owns a scratch buffer (GetJobScratch()) that work functions reuse for
+*   large temporary data instead of allocating it per job.
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+
+#if defined(PLATFORM_WEB)
+    #if defined(__EMSCRIPTEN_PTHREADS__)
+        #define LIZARD_JOBS_THREADED 1
+        #include <emscripten/threading.h>   // Required for: emscripten_num_logical_cores()
+    #endif
+#elif defined(_MSC_VER)
+    #define LIZARD_JOBS_THREADED 1
+    #define LIZARD_JOBS_WIN32 1
+#else
+    #define LIZARD_JOBS_THREADED 1
+    #include <unistd.h>                     // Required for: sysconf()
+#endif
+
+#if defined(LIZARD_JOBS_WIN32)
+    #include <process.h>                    // Required for: _beginthreadex()
+
+    // NOTE: windows.h clashes with raylib names (Rectangle, CloseWindow, DrawText...), so the few
+    // functions needed are declared here, the same way raylib's rcore declares Sleep()
+    typedef struct { void* ptr; } JobLock;         // SRWLOCK
+    typedef struct { void* ptr; } JobCondition;    // CONDITION_VARIABLE
+    typedef void* JobThread;                        // HANDLE
+
+    __declspec(dllimport) void __stdcall InitializeSRWLock(JobLock* lock);
+    __declspec(dllimport) void __stdcall AcquireSRWLockExclusive(JobLock* lock);
+    __declspec(dllimport) void __stdcall ReleaseSRWLockExclusive(JobLock* lock);
+    __declspec(dllimport) void __stdcall InitializeConditionVariable(JobCondition* condition);
+    __declspec(dllimport) int __stdcall SleepConditionVariableSRW(JobCondition* condition, JobLock* lock, unsigned long milliseconds, unsigned long flags);
+    __declspec(dllimport) void __stdcall WakeConditionVariable(JobCondition* condition);
+    __declspec(dllimport) void __stdcall WakeAllConditionVariable(JobCondition* condition);
+    __declspec(dllimport) unsigned long __stdcall WaitForSingleObject(void* handle, unsigned long milliseconds);
+    __declspec(dllimport) int __stdcall CloseHandle(void* handle);
+    __declspec(dllimport) unsigned long __stdcall GetActiveProcessorCount(unsigned short groupNumber);
+
+    #define JOB_THREAD_LOCAL __declspec(thread)
+    #define InitJobLock(lock) InitializeSRWLock(lock)
+    #define DestroyJobLock(lock) ((void)(lock))
+    #define LockJobs(lock) AcquireSRWLockExclusive(lock)
+    #define UnlockJobs(lock) ReleaseSRWLockExclusive(lock)
+    #define InitJobCondition(condition) InitializeConditionVariable(condition)
+    #define DestroyJobCondition(condition) ((void)(condition))
+    #define WaitJobCondition(condition, lock) SleepConditionVariableSRW(condition, lock, 0xFFFFFFFF, 0)
+    #define SignalJobCondition(condition) WakeConditionVariable(condition)
+    #define BroadcastJobCondition(condition) WakeAllConditionVariable(condition)
+#elif defined(LIZARD_JOBS_THREADED)
+    #include <pthread.h>
+
+    typedef pthread_mutex_t JobLock;
+    typedef pthread_cond_t JobCondition;
+    typedef pthread_t JobThread;
+
+    #define JOB_THREAD_LOCAL __thread
+    #define InitJobLock(lock) pthread_mutex_init(lock, NULL)
+    #define DestroyJobLock(lock) pthread_mutex_destroy(lock)
+    #define LockJobs(lock) pthread_mutex_lock(lock)
+    #define UnlockJobs(lock) pthread_mutex_unlock(lock)
+    #define InitJobCondition(condition) pthread_cond_init(condition, NULL)
+    #define DestroyJobCondition(condition) pthread_cond_destroy(condition)
+    #define WaitJobCondition(condition, lock) pthread_cond_wait(condition, lock)
+    #define SignalJobCondition(condition) pthread_cond_signal(condition)
+    #define BroadcastJobCondition(condition) pthread_cond_broadcast(condition)
+#endif
+
+#include <stddef.h>                         // Required for: size_t
+
+#define MAX_JOB_WORKERS 16
+#define MAX_QUEUED_JOBS 1024
+
+typedef void (*JobFunction)(void* data);
+
+typedef struct {
+    JobFunction work;       // Runs on a worker thread
+    JobFunction complete;   // Runs on the main thread, may be NULL
+    void* data;
+} Job;
+
+// Fixed size ring buffer of jobs
+typedef struct {
+    Job jobs[MAX_QUEUED_JOBS];
+    int head;
+    int count;
+} JobQueue;
+
+JobQueue pendingJobs = { 0 };   // Waiting for a worker
+JobQueue finishedJobs = { 0 };  // Waiting for their completion on the main thread
+int jobWorkerCount = 0;
+int jobsInFlight = 0;           // Scheduled jobs whose completion has not run yet (main thread only)
+
+// Reusable per thread memory, slot 0 belongs to the main thread and slot i + 1 to worker i
+typedef struct {
+    void* data;
+    int size;
+} JobScratch;
+
+JobScratch jobScratch[MAX_JOB_WORKERS + 1] = { 0 };
+
+#if defined(LIZARD_JOBS_THREADED)
+static JOB_THREAD_LOCAL int jobThreadIndex = 0;
+JobThread jobWorkers[MAX_JOB_WORKERS];
+JobLock pendingJobsMutex;
+JobLock finishedJobsMutex;
+JobCondition pendingJobsCondition;
+bool jobWorkersRunning = false;
+#else
+static int jobThreadIndex = 0;
+#endif
+
+bool PushJob(JobQueue* queue, Job job)
+{
+    if (queue->count == MAX_QUEUED_JOBS) return false;
+    queue->jobs[(queue->head + queue->count) % MAX_QUEUED_JOBS] = job;
+    queue->count++;
+    return true;
+}
+
+bool PopJob(JobQueue* queue, Job* job)
+{
+    if (queue->count == 0) return false;
+    *job = queue->jobs[queue->head];
+    queue->head = (queue->head + 1) % MAX_QUEUED_JOBS;
+    queue->count--;
+    return true;
+}
+
+// Number of logical cores, used to size the pool
+int GetCpuCoreCount(void)
+{
+    int cores = 1;
+#if defined(LIZARD_JOBS_THREADED)
+    #if defined(PLATFORM_WEB)
+        cores = emscripten_num_logical_cores();
+    #elif defined(LIZARD_JOBS_WIN32)
+        cores = (int)GetActiveProcessorCount(0xFFFF);   // ALL_PROCESSOR_GROUPS
+    #elif defined(_SC_NPROCESSORS_ONLN)
+        cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    #elif defined(__MINGW32__)
+        cores = pthread_num_processors_np();
+    #endif
+#endif
+    return (cores > 0) ? cores : 1;
+}
+
+#if defined(LIZARD_JOBS_THREADED)
+void JobWorkerLoop(int threadIndex)
+{
+    jobThreadIndex = threadIndex;
+
+    while (true)
+    {
+        Job job = { 0 };
+
+        LockJobs(&pendingJobsMutex);
+        while (jobWorkersRunning && !PopJob(&pendingJobs, &job)) WaitJobCondition(&pendingJobsCondition, &pendingJobsMutex);
+        bool running = jobWorkersRunning;
+        UnlockJobs(&pendingJobsMutex);
+
+        if (!running) break;
+
+        job.work(job.data);
+
+        // NOTE: finishedJobs can hold every job in flight, pushes never fail
+        LockJobs(&finishedJobsMutex);
+        PushJob(&finishedJobs, job);
+        UnlockJobs(&finishedJobsMutex);
+    }
+}
+
+#if defined(LIZARD_JOBS_WIN32)
+unsigned __stdcall JobWorkerMain(void* arg)
+{
+    JobWorkerLoop((int)(size_t)arg);
+    return 0;
+}
+
+bool StartJobWorker(JobThread* thread, int threadIndex)
+{
+    *thread = (JobThread)_beginthreadex(NULL, 0, JobWorkerMain, (void*)(size_t)threadIndex, 0, NULL);
+    return (*thread != NULL);
+}
+
+void JoinJobWorker(JobThread thread)
+{
+    WaitForSingleObject(thread, 0xFFFFFFFF);    // INFINITE
+    CloseHandle(thread);
+}
+#else
+void* JobWorkerMain(void* arg)
+{
+    JobWorkerLoop((int)(size_t)arg);
+    return NULL;
+}
+
+bool StartJobWorker(JobThread* thread, int threadIndex)
+{
+    return (pthread_create(thread, NULL, JobWorkerMain, (void*)(size_t)threadIndex) == 0);
+}
+
+void JoinJobWorker(JobThread thread)
+{
+    pthread_join(thread, NULL);
+}
+#endif
+#endif
+
+// Start the worker pool, workerCount <= 0 uses one worker per core minus the main thread
+void InitJobSystem(int workerCount)
+{
+    pendingJobs = (JobQueue){ 0 };
+    finishedJobs = (JobQueue){ 0 };
+    jobsInFlight = 0;
+    jobWorkerCount = 0;
+
+#if defined(LIZARD_JOBS_THREADED)
+    if (workerCount <= 0) workerCount = GetCpuCoreCount() - 1;
+    if (workerCount < 1) workerCount = 1;
+    if (workerCount > MAX_JOB_WORKERS) workerCount = MAX_JOB_WORKERS;
+
+    InitJobLock(&pendingJobsMutex);
+    InitJobLock(&finishedJobsMutex);
+    InitJobCondition(&pendingJobsCondition);
+    jobWorkersRunning = true;
+
+    for (int i = 0; i < workerCount; i++)
+    {
+        if (!StartJobWorker(&jobWorkers[i], i + 1)) break;
+        jobWorkerCount++;
+    }
+
+    TraceLog(LOG_INFO, "JOBS: Started %i worker threads", jobWorkerCount);
+#else
+    (void)workerCount;
+    TraceLog(LOG_INFO, "JOBS: No thread support, jobs run synchronously");
+#endif
+}
+
+// Stop and join all workers, pending jobs that did not start are dropped
+void ShutdownJobSystem(void)
+{
+#if defined(LIZARD_JOBS_THREADED)
+    if (jobWorkersRunning)
+    {
+        LockJobs(&pendingJobsMutex);
+        jobWorkersRunning = false;
+        BroadcastJobCondition(&pendingJobsCondition);
+        UnlockJobs(&pendingJobsMutex);
+
+        for (int i = 0; i < jobWorkerCount; i++) JoinJobWorker(jobWorkers[i]);
+
+        DestroyJobLock(&pendingJobsMutex);
+        DestroyJobLock(&finishedJobsMutex);
+        DestroyJobCondition(&pendingJobsCondition);
+    }
+#endif
+    jobWorkerCount = 0;
+
+    for (int i = 0; i <= MAX_JOB_WORKERS; i++)
+    {
+        if (jobScratch[i].data != NULL) MemFree(jobScratch[i].data);
+        jobScratch[i] = (JobScratch){ 0 };
+    }
+}
+
+// Scratch memory of the calling thread, at least size bytes. The buffer is reused by the next call on the
+// same thread, so the contents must be copied out before the job ends.
+void* GetJobScratch(int size)
+{
+    JobScratch* scratch = &jobScratch[jobThreadIndex];
+
+    if (scratch->size < size)
+    {
+        if (scratch->data != NULL) MemFree(scratch->data);
+        scratch->data = MemAlloc(size);
+        scratch->size = size;
+    }
+
+    return scratch->data;
+}
+
+// Queue a job (main thread only), returns false if the queue is full
+bool ScheduleJob(JobFunction work, JobFunction complete, void* data)
+{
+    if (jobsInFlight >= MAX_QUEUED_JOBS) return false;
+
+    Job job = { work, complete, data };
+    jobsInFlight++;
+
+#if defined(LIZARD_JOBS_THREADED)
+    if (jobWorkerCount > 0)
+    {
+        LockJobs(&pendingJobsMutex);
+        PushJob(&pendingJobs, job);
+        SignalJobCondition(&pendingJobsCondition);
+        UnlockJobs(&pendingJobsMutex);
+        return true;
+    }
+#endif
+
+    // No workers: do the work now, the completion still waits for RunJobCompletions()
+    job.work(job.data);
+    PushJob(&finishedJobs, job);
+    return true;
+}
+
+// Run completions of finished jobs on the main thread until timeBudget seconds are used,
+// at least one completion runs per call so work always makes progress. Returns the number run.
+int RunJobCompletions(double timeBudget)
+{
+    double startTime = GetTime();
+    int completed = 0;
+
+    while (true)
+    {
+        Job job = { 0 };
+
+#if defined(LIZARD_JOBS_THREADED)
+        LockJobs(&finishedJobsMutex);
+        bool found = PopJob(&finishedJobs, &job);
+        UnlockJobs(&finishedJobsMutex);
+#else
+        bool found = PopJob(&finishedJobs, &job);
+#endif
+        if (!found) break;
+
+        if (job.complete != NULL) job.complete(job.data);
+        jobsInFlight--;
+        completed++;
+
+        if (GetTime() - startTime >= timeBudget) break;
+    }
+
+    return completed;
+}
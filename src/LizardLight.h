@@ -0,0 +1,346 @@
+/*******************************************************************************************
+*
+*   LizardLight * Sky light and block light flood filled through the blocks
+*
+*   Every block stores one light byte: sky light in the high nibble, block light in the low one,
+*   both 0..15. Sky light enters from above the world at 15 and keeps 15 going straight down, block
+*   light starts at the emission of its block type. Each step to a non-opaque neighbour costs one level.
+*
+*   A new chunk column is lit on its own with LightChunkColumn(), on the worker that fills its blocks.
+*   Everything after that is incremental breadth first search over world coordinates:
+*     - QueueLightSeed() queues a block whose light should spread further (column seams)
+*     - QueueBlockLightChange() queues the light changes of one block edit
+*     - UpdateLight() clears the light that lost its source and spreads light again from the border
+*       of the cleared area, so its cost follows the size of the change, not of the world. It stops
+*       once its time budget is used and picks up the queues where it left off on the next call.
+*   The incremental part reads and writes the world through the callbacks given to InitLight(), main
+*   thread only. The light of unloaded blocks is left alone, their seams are lit when they arrive.
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+#include "LizardBlockWorld.h"
+#include "LizardBlockRaycast.h"             // Required for: GetBlockCallback
+
+#include <string.h>                         // Required for: memset()
+
+#define MAX_LIGHT_LEVEL 15
+#define FULL_SKY_LIGHT 0xf0                 // Open sky, no block light
+#define LIGHT_SKY(light) ((light) >> 4)
+#define LIGHT_BLOCK(light) ((light) & 0x0f)
+// Index of block (x, y, z) in a column sized array, one CHUNK_VOLUME section after the other, y is the column height
+#define COLUMN_BLOCK_INDEX(x, y, z) (((y) / CHUNK_SIZE) * CHUNK_VOLUME + BLOCK_INDEX((x), (y) % CHUNK_SIZE, (z)))
+#define COLUMN_VOLUME (CHUNK_SECTIONS * CHUNK_VOLUME)
+#define LIGHT_UPDATE_STEPS 4096             // Blocks visited by UpdateLight() between checks of its time budget
+#define LIGHT_COLUMN_QUEUE_SIZE 65536       // Entries of the LightChunkColumn() queue
+
+enum LightChannel
+{
+    LightSky,
+    LightBlock,
+    LightChannelCount
+};
+
+// Light byte at a world block coordinate
+typedef unsigned char (*GetLightCallback)(int x, int y, int z);
+// Write the light byte at a world block coordinate, returns false where there is no light data to write
+typedef bool (*SetLightCallback)(int x, int y, int z, unsigned char light);
+
+typedef struct {
+    int x, y, z;
+    int level;                              // Removal: the level the block had before it was cleared
+} LightNode;
+
+// First in first out queue of light nodes, grows as needed
+typedef struct {
+    LightNode* nodes;
+    int head;
+    int count;
+    int capacity;
+} LightQueue;
+
+static const int lightDirections[6][3] = { { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 } };
+
+GetBlockCallback lightGetBlock = NULL;
+GetLightCallback lightGetLight = NULL;
+SetLightCallback lightSetLight = NULL;
+LightQueue lightAddQueues[LightChannelCount] = { 0 };
+LightQueue lightRemoveQueues[LightChannelCount] = { 0 };
+
+void InitLight(GetBlockCallback getBlock, GetLightCallback getLight, SetLightCallback setLight)
+{
+    lightGetBlock = getBlock;
+    lightGetLight = getLight;
+    lightSetLight = setLight;
+}
+
+void ShutdownLight(void)
+{
+    for (int c = 0; c < LightChannelCount; c++)
+    {
+        MemFree(lightAddQueues[c].nodes);
+        MemFree(lightRemoveQueues[c].nodes);
+        lightAddQueues[c] = (LightQueue){ 0 };
+        lightRemoveQueues[c] = (LightQueue){ 0 };
+    }
+}
+
+static void PushLightNode(LightQueue* queue, int x, int y, int z, int level)
+{
+    // Compact the consumed front before growing
+    if (queue->head + queue->count == queue->capacity)
+    {
+        if (queue->head > queue->capacity / 2) memmove(queue->nodes, &queue->nodes[queue->head], queue->count * sizeof(LightNode));
+        else
+        {
+            queue->capacity = (queue->capacity == 0) ? 4096 : queue->capacity * 2;
+            LightNode* nodes = (LightNode*)MemAlloc(queue->capacity * sizeof(LightNode));
+            if (queue->count > 0) memcpy(nodes, &queue->nodes[queue->head], queue->count * sizeof(LightNode));
+            MemFree(queue->nodes);
+            queue->nodes = nodes;
+        }
+        queue->head = 0;
+    }
+
+    queue->nodes[queue->head + queue->count++] = (LightNode){ x, y, z, level };
+}
+
+static LightNode PopLightNode(LightQueue* queue)
+{
+    LightNode node = queue->nodes[queue->head++];
+    if (--queue->count == 0) queue->head = 0;
+    return node;
+}
+
+static inline int GetLightLevel(unsigned char light, int channel)
+{
+    return (channel == LightSky) ? LIGHT_SKY(light) : LIGHT_BLOCK(light);
+}
+
+static inline unsigned char SetLightLevel(unsigned char light, int channel, int level)
+{
+    return (channel == LightSky) ? (unsigned char)((light & 0x0f) | (level << 4)) : (unsigned char)((light & 0xf0) | level);
+}
+
+// Level light reaches a neighbour with, sky light at full strength does not fade going down
+static inline int GetSpreadLevel(int channel, int level, int direction)
+{
+    return (channel == LightSky && level == MAX_LIGHT_LEVEL && direction == 2) ? MAX_LIGHT_LEVEL : level - 1;
+}
+
+// Whether light spreads from a block to a sideways neighbour of type toType, making it brighter
+bool IsLightSpreading(unsigned char from, unsigned char to, unsigned char toType)
+{
+    if (blockTypes[toType].opaque) return false;
+    return (LIGHT_SKY(from) - 1 > LIGHT_SKY(to)) || (LIGHT_BLOCK(from) - 1 > LIGHT_BLOCK(to));
+}
+
+// Queue a block whose light should spread to its neighbours, e.g. along the seam between two lit columns
+void QueueLightSeed(int x, int y, int z)
+{
+    for (int c = 0; c < LightChannelCount; c++) PushLightNode(&lightAddQueues[c], x, y, z, 0);
+}
+
+// Queue the light changes of a block that was just set to newType: its old light is cleared, an emitting block
+// lights itself and a non-opaque one lets its neighbours' light back in
+void QueueBlockLightChange(int x, int y, int z, unsigned char newType)
+{
+    unsigned char light = lightGetLight(x, y, z);
+
+    for (int c = 0; c < LightChannelCount; c++)
+    {
+        int level = GetLightLevel(light, c);
+        if (level > 0) PushLightNode(&lightRemoveQueues[c], x, y, z, level);
+
+        int emission = (c == LightBlock) ? blockTypes[newType].emission : 0;
+        light = SetLightLevel(light, c, emission);
+        if (emission > 0) PushLightNode(&lightAddQueues[c], x, y, z, 0);
+
+        if (blockTypes[newType].opaque) continue;
+        for (int d = 0; d < 6; d++) PushLightNode(&lightAddQueues[c], x + lightDirections[d][0], y + lightDirections[d][1], z + lightDirections[d][2], 0);
+    }
+
+    lightSetLight(x, y, z, light);
+}
+
+// Clear the light that came from the removed nodes, at most maxSteps of them. Neighbours lit by some other source
+// are queued to spread again.
+static int RemoveLight(int channel, int maxSteps)
+{
+    LightQueue* queue = &lightRemoveQueues[channel];
+    int steps = 0;
+
+    while (queue->count > 0 && steps < maxSteps)
+    {
+        LightNode node = PopLightNode(queue);
+        steps++;
+
+        for (int d = 0; d < 6; d++)
+        {
+            int x = node.x + lightDirections[d][0];
+            int y = node.y + lightDirections[d][1];
+            int z = node.z + lightDirections[d][2];
+            unsigned char light = lightGetLight(x, y, z);
+            int level = GetLightLevel(light, channel);
+            if (level == 0) continue;
+
+            if (level <= GetSpreadLevel(channel, node.level, d) && lightSetLight(x, y, z, SetLightLevel(light, channel, 0)))
+            {
+                PushLightNode(queue, x, y, z, level);
+            }
+            else PushLightNode(&lightAddQueues[channel], x, y, z, 0);
+        }
+    }
+
+    return steps;
+}
+
+// Spread the light of the queued nodes to every non-opaque neighbour it would make brighter, at most maxSteps nodes
+static int SpreadLight(int channel, int maxSteps)
+{
+    LightQueue* queue = &lightAddQueues[channel];
+    int steps = 0;
+
+    while (queue->count > 0 && steps < maxSteps)
+    {
+        LightNode node = PopLightNode(queue);
+        int level = GetLightLevel(lightGetLight(node.x, node.y, node.z), channel);
+        steps++;
+        if (level <= 1) continue;
+
+        for (int d = 0; d < 6; d++)
+        {
+            int x = node.x + lightDirections[d][0];
+            int y = node.y + lightDirections[d][1];
+            int z = node.z + lightDirections[d][2];
+            if (blockTypes[lightGetBlock(x, y, z)].opaque) continue;
+
+            int spread = GetSpreadLevel(channel, level, d);
+            unsigned char light = lightGetLight(x, y, z);
+            if (GetLightLevel(light, channel) >= spread) continue;
+
+            if (lightSetLight(x, y, z, SetLightLevel(light, channel, spread))) PushLightNode(queue, x, y, z, 0);
+        }
+    }
+
+    return steps;
+}
+
+// Whether queued light changes are still waiting for UpdateLight()
+bool IsLightPending(void)
+{
+    for (int c = 0; c < LightChannelCount; c++)
+    {
+        if (lightRemoveQueues[c].count > 0 || lightAddQueues[c].count > 0) return true;
+    }
+    return false;
+}
+
+// Run the queued light changes until they are done or timeBudget seconds are used, returns the number of blocks
+// visited. Removals run before any spreading, so a paused update resumes in the same order.
+int UpdateLight(double timeBudget)
+{
+    double startTime = GetTime();
+    int steps = 0;
+
+    while (IsLightPending() && GetTime() - startTime < timeBudget)
+    {
+        for (int c = 0; c < LightChannelCount; c++)
+        {
+            steps += RemoveLight(c, LIGHT_UPDATE_STEPS);
+            if (lightRemoveQueues[c].count == 0) steps += SpreadLight(c, LIGHT_UPDATE_STEPS);
+        }
+    }
+    return steps;
+}
+
+// Light a chunk column on its own, as if everything around it was dark: sky light falls down every column of
+// blocks until the first opaque one, then both channels spread sideways inside the column. types and light are
+// COLUMN_VOLUME arrays indexed with COLUMN_BLOCK_INDEX, queue is room for LIGHT_COLUMN_QUEUE_SIZE indices (job
+// scratch memory). Safe to call from worker threads.
+void LightChunkColumn(const unsigned char* types, unsigned char* light, unsigned short* queue)
+{
+    // Ring queue of column indices, a block is only queued again when it got brighter
+    unsigned short head = 0;
+    unsigned short tail = 0;
+
+    memset(light, 0, COLUMN_VOLUME);
+    for (int x = 0; x < CHUNK_SIZE; x++)
+    {
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            for (int y = WORLD_HEIGHT - 1; y >= 0; y--)
+            {
+                int index = COLUMN_BLOCK_INDEX(x, y, z);
+                if (blockTypes[types[index]].opaque) break;
+                light[index] = FULL_SKY_LIGHT;
+            }
+        }
+    }
+
+    for (int c = 0; c < LightChannelCount; c++)
+    {
+        // Seeds: sky lit blocks next to a darker see-through block, emitting blocks
+        for (int x = 0; x < CHUNK_SIZE; x++)
+        {
+            for (int y = 0; y < WORLD_HEIGHT; y++)
+            {
+                for (int z = 0; z < CHUNK_SIZE; z++)
+                {
+                    int index = COLUMN_BLOCK_INDEX(x, y, z);
+
+                    if (c == LightBlock)
+                    {
+                        int emission = blockTypes[types[index]].emission;
+                        if (emission == 0) continue;
+                        light[index] = SetLightLevel(light[index], c, emission);
+                        queue[tail++] = (unsigned short)index;
+                        continue;
+                    }
+
+                    if (light[index] != FULL_SKY_LIGHT) continue;
+                    for (int d = 0; d < 6; d++)
+                    {
+                        int nx = x + lightDirections[d][0];
+                        int ny = y + lightDirections[d][1];
+                        int nz = z + lightDirections[d][2];
+                        if (nx < 0 || nx >= CHUNK_SIZE || ny < 0 || ny >= WORLD_HEIGHT || nz < 0 || nz >= CHUNK_SIZE) continue;
+
+                        int next = COLUMN_BLOCK_INDEX(nx, ny, nz);
+                        if (light[next] == FULL_SKY_LIGHT || blockTypes[types[next]].opaque) continue;
+                        queue[tail++] = (unsigned short)index;
+                        break;
+                    }
+                }
+            }
+        }
+
+        while (head != tail)
+        {
+            int index = queue[head++];
+            int level = GetLightLevel(light[index], c);
+            if (level <= 1) continue;
+
+            int x = index % CHUNK_VOLUME / (CHUNK_SIZE * CHUNK_SIZE);
+            int y = index / CHUNK_VOLUME * CHUNK_SIZE + (index / CHUNK_SIZE) % CHUNK_SIZE;
+            int z = index % CHUNK_SIZE;
+
+            for (int d = 0; d < 6; d++)
+            {
+                int nx = x + lightDirections[d][0];
+                int ny = y + lightDirections[d][1];
+                int nz = z + lightDirections[d][2];
+                if (nx < 0 || nx >= CHUNK_SIZE || ny < 0 || ny >= WORLD_HEIGHT || nz < 0 || nz >= CHUNK_SIZE) continue;
+
+                int next = COLUMN_BLOCK_INDEX(nx, ny, nz);
+                int spread = GetSpreadLevel(c, level, d);
+                if (blockTypes[types[next]].opaque || GetLightLevel(light[next], c) >= spread) continue;
+
+                light[next] = SetLightLevel(light[next], c, spread);
+                queue[tail++] = (unsigned short)next;
+            }
+        }
+    }
+}
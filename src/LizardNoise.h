@@ -0,0 +1,255 @@
+/*******************************************************************************************
+*
+*   LizardNoise * Seeded, coordinate based gradient noise for terrain generation
+*
+*   Every sample is computed from the integer lattice around the input coordinate, so any
+*   point of an infinite world can be evaluated on its own without a baked noise image.
+*
+*   FractalNoise2D4() evaluates four points at once with SSE2 on x86 and SIMD128 on WebAssembly
+*   (emcc -msimd128), other targets run the scalar code four times. Both paths do the same IEEE
+*   float operations in the same order and give bit identical results, so a seed gives the same
+*   world on every platform as long as the compiler does not fuse multiply-adds (-ffp-contract=off).
+*
+********************************************************************************************/
+
+#pragma once
+
+#include <math.h>                           // Required for: floorf()
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define LIZARD_NOISE_SSE2
+    #include <emmintrin.h>                  // Required for: SSE2 intrinsics
+#elif defined(__wasm_simd128__)
+    #define LIZARD_NOISE_WASM_SIMD
+    #include <wasm_simd128.h>               // Required for: WebAssembly SIMD128 intrinsics
+#endif
+
+// Hash a 2D lattice point into 32 bits
+unsigned int NoiseHash2D(int x, int z, unsigned int seed)
+{
+    unsigned int hash = seed;
+    hash ^= (unsigned int)x * 0x27d4eb2dU;
+    hash ^= (unsigned int)z * 0x165667b1U;
+    hash = (hash ^ (hash >> 15)) * 0x2c1b3c6dU;
+    hash = (hash ^ (hash >> 12)) * 0x297a2d39U;
+    return hash ^ (hash >> 15);
+}
+
+// Dot product of one of 8 lattice gradients with the offset (x, z)
+float NoiseGradient2D(unsigned int hash, float x, float z)
+{
+    switch (hash & 7)
+    {
+        case 0: return x + z;
+        case 1: return -x + z;
+        case 2: return x - z;
+        case 3: return -x - z;
+        case 4: return x;
+        case 5: return -x;
+        case 6: return z;
+        default: return -z;
+    }
+}
+
+// Quintic fade curve, keeps the noise C2 continuous across lattice cells
+float NoiseFade(float t)
+{
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+// 2D Perlin noise, returns roughly [-1, 1]
+float PerlinNoise2D(float x, float z, unsigned int seed)
+{
+    float cellX = floorf(x);
+    float cellZ = floorf(z);
+    int ix = (int)cellX;
+    int iz = (int)cellZ;
+    float fx = x - cellX;
+    float fz = z - cellZ;
+
+    float n00 = NoiseGradient2D(NoiseHash2D(ix, iz, seed), fx, fz);
+    float n10 = NoiseGradient2D(NoiseHash2D(ix + 1, iz, seed), fx - 1.0f, fz);
+    float n01 = NoiseGradient2D(NoiseHash2D(ix, iz + 1, seed), fx, fz - 1.0f);
+    float n11 = NoiseGradient2D(NoiseHash2D(ix + 1, iz + 1, seed), fx - 1.0f, fz - 1.0f);
+
+    float u = NoiseFade(fx);
+    float v = NoiseFade(fz);
+    float nx0 = n00 + u * (n10 - n00);
+    float nx1 = n01 + u * (n11 - n01);
+    return nx0 + v * (nx1 - nx0);
+}
+
+// Fractal (fBm) Perlin noise: octaves of doubling frequency and halving amplitude, normalized to roughly [-1, 1]
+float FractalNoise2D(float x, float z, unsigned int seed, int octaves)
+{
+    float sum = 0.0f;
+    float amplitude = 1.0f;
+    float amplitudeSum = 0.0f;
+    float frequency = 1.0f;
+
+    for (int i = 0; i < octaves; i++)
+    {
+        sum += PerlinNoise2D(x * frequency, z * frequency, seed + i) * amplitude;
+        amplitudeSum += amplitude;
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+
+    return sum / amplitudeSum;
+}
+
+#if defined(LIZARD_NOISE_SSE2) || defined(LIZARD_NOISE_WASM_SIMD)
+
+// Four lane float and int vectors, the noise below is written once against these
+#if defined(LIZARD_NOISE_SSE2)
+typedef __m128 NoiseFloat4;
+typedef __m128i NoiseInt4;
+
+#define NoiseLoadF(p) _mm_loadu_ps(p)
+#define NoiseStoreF(p, a) _mm_storeu_ps(p, a)
+#define NoiseSetF(v) _mm_set1_ps(v)
+#define NoiseSetI(v) _mm_set1_epi32((int)(v))
+#define NoiseAddF(a, b) _mm_add_ps(a, b)
+#define NoiseSubF(a, b) _mm_sub_ps(a, b)
+#define NoiseMulF(a, b) _mm_mul_ps(a, b)
+#define NoiseDivF(a, b) _mm_div_ps(a, b)
+#define NoiseLessF(a, b) _mm_castps_si128(_mm_cmplt_ps(a, b))
+#define NoiseAddI(a, b) _mm_add_epi32(a, b)
+#define NoiseAndI(a, b) _mm_and_si128(a, b)
+#define NoiseXorI(a, b) _mm_xor_si128(a, b)
+#define NoiseEqualI(a, b) _mm_cmpeq_epi32(a, b)
+#define NoiseShiftLeftI(a, n) _mm_slli_epi32(a, n)
+#define NoiseShiftRightI(a, n) _mm_srli_epi32(a, n)
+#define NoiseTruncateF(a) _mm_cvttps_epi32(a)
+#define NoiseConvertI(a) _mm_cvtepi32_ps(a)
+#define NoiseAsFloat(a) _mm_castsi128_ps(a)
+#define NoiseAsInt(a) _mm_castps_si128(a)
+
+// Low 32 bits of a 32 bit multiply, SSE2 only multiplies the even lanes into 64 bits
+static inline NoiseInt4 NoiseMulI(NoiseInt4 a, NoiseInt4 b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#else
+typedef v128_t NoiseFloat4;
+typedef v128_t NoiseInt4;
+
+#define NoiseLoadF(p) wasm_v128_load(p)
+#define NoiseStoreF(p, a) wasm_v128_store(p, a)
+#define NoiseSetF(v) wasm_f32x4_splat(v)
+#define NoiseSetI(v) wasm_i32x4_splat((int)(v))
+#define NoiseAddF(a, b) wasm_f32x4_add(a, b)
+#define NoiseSubF(a, b) wasm_f32x4_sub(a, b)
+#define NoiseMulF(a, b) wasm_f32x4_mul(a, b)
+#define NoiseDivF(a, b) wasm_f32x4_div(a, b)
+#define NoiseLessF(a, b) wasm_f32x4_lt(a, b)
+#define NoiseAddI(a, b) wasm_i32x4_add(a, b)
+#define NoiseAndI(a, b) wasm_v128_and(a, b)
+#define NoiseXorI(a, b) wasm_v128_xor(a, b)
+#define NoiseEqualI(a, b) wasm_i32x4_eq(a, b)
+#define NoiseShiftLeftI(a, n) wasm_i32x4_shl(a, n)
+#define NoiseShiftRightI(a, n) wasm_u32x4_shr(a, n)
+#define NoiseTruncateF(a) wasm_i32x4_trunc_sat_f32x4(a)
+#define NoiseConvertI(a) wasm_f32x4_convert_i32x4(a)
+#define NoiseAsFloat(a) (a)
+#define NoiseAsInt(a) (a)
+#define NoiseMulI(a, b) wasm_i32x4_mul(a, b)
+#endif
+
+// NoiseHash2D() on four lattice points
+static inline NoiseInt4 NoiseHash2D4(NoiseInt4 x, NoiseInt4 z, unsigned int seed)
+{
+    NoiseInt4 hash = NoiseSetI(seed);
+    hash = NoiseXorI(hash, NoiseMulI(x, NoiseSetI(0x27d4eb2dU)));
+    hash = NoiseXorI(hash, NoiseMulI(z, NoiseSetI(0x165667b1U)));
+    hash = NoiseMulI(NoiseXorI(hash, NoiseShiftRightI(hash, 15)), NoiseSetI(0x2c1b3c6dU));
+    hash = NoiseMulI(NoiseXorI(hash, NoiseShiftRightI(hash, 12)), NoiseSetI(0x297a2d39U));
+    return NoiseXorI(hash, NoiseShiftRightI(hash, 15));
+}
+
+// NoiseGradient2D() on four points without branches: each term is kept or zeroed by a mask and negated by
+// flipping its sign bit, giving the same sums as the switch
+static inline NoiseFloat4 NoiseGradient2D4(NoiseInt4 hash, NoiseFloat4 x, NoiseFloat4 z)
+{
+    NoiseInt4 h = NoiseAndI(hash, NoiseSetI(7));
+    NoiseInt4 one = NoiseSetI(1);
+    NoiseInt4 allBits = NoiseSetI(-1);
+    NoiseInt4 pair = NoiseAndI(h, NoiseSetI(6));
+
+    NoiseInt4 useX = NoiseXorI(NoiseEqualI(pair, NoiseSetI(6)), allBits);    // Not cases 6, 7
+    NoiseInt4 useZ = NoiseXorI(NoiseEqualI(pair, NoiseSetI(4)), allBits);    // Not cases 4, 5
+    NoiseInt4 negateX = NoiseShiftLeftI(NoiseAndI(h, one), 31);              // Cases 1, 3, 5
+    NoiseInt4 negateZ = NoiseShiftLeftI(NoiseAndI(NoiseXorI(NoiseShiftRightI(h, 1), NoiseAndI(NoiseShiftRightI(h, 2), NoiseXorI(h, one))), one), 31); // Cases 2, 3, 7
+
+    NoiseFloat4 termX = NoiseAsFloat(NoiseAndI(NoiseXorI(NoiseAsInt(x), negateX), useX));
+    NoiseFloat4 termZ = NoiseAsFloat(NoiseAndI(NoiseXorI(NoiseAsInt(z), negateZ), useZ));
+    return NoiseAddF(termX, termZ);
+}
+
+// NoiseFade() on four values
+static inline NoiseFloat4 NoiseFade4(NoiseFloat4 t)
+{
+    NoiseFloat4 inner = NoiseAddF(NoiseMulF(t, NoiseSubF(NoiseMulF(t, NoiseSetF(6.0f)), NoiseSetF(15.0f))), NoiseSetF(10.0f));
+    return NoiseMulF(NoiseMulF(NoiseMulF(t, t), t), inner);
+}
+
+// PerlinNoise2D() on four points
+static inline NoiseFloat4 PerlinNoise2D4(NoiseFloat4 x, NoiseFloat4 z, unsigned int seed)
+{
+    // floorf(): truncate, then step down where that rounded up (negative inputs)
+    NoiseInt4 ix = NoiseTruncateF(x);
+    NoiseInt4 iz = NoiseTruncateF(z);
+    NoiseInt4 roundedUpX = NoiseLessF(x, NoiseConvertI(ix));
+    NoiseInt4 roundedUpZ = NoiseLessF(z, NoiseConvertI(iz));
+    ix = NoiseAddI(ix, roundedUpX);
+    iz = NoiseAddI(iz, roundedUpZ);
+
+    NoiseFloat4 fx = NoiseSubF(x, NoiseConvertI(ix));
+    NoiseFloat4 fz = NoiseSubF(z, NoiseConvertI(iz));
+    NoiseFloat4 fx1 = NoiseSubF(fx, NoiseSetF(1.0f));
+    NoiseFloat4 fz1 = NoiseSubF(fz, NoiseSetF(1.0f));
+    NoiseInt4 ix1 = NoiseAddI(ix, NoiseSetI(1));
+    NoiseInt4 iz1 = NoiseAddI(iz, NoiseSetI(1));
+
+    NoiseFloat4 n00 = NoiseGradient2D4(NoiseHash2D4(ix, iz, seed), fx, fz);
+    NoiseFloat4 n10 = NoiseGradient2D4(NoiseHash2D4(ix1, iz, seed), fx1, fz);
+    NoiseFloat4 n01 = NoiseGradient2D4(NoiseHash2D4(ix, iz1, seed), fx, fz1);
+    NoiseFloat4 n11 = NoiseGradient2D4(NoiseHash2D4(ix1, iz1, seed), fx1, fz1);
+
+    NoiseFloat4 u = NoiseFade4(fx);
+    NoiseFloat4 v = NoiseFade4(fz);
+    NoiseFloat4 nx0 = NoiseAddF(n00, NoiseMulF(u, NoiseSubF(n10, n00)));
+    NoiseFloat4 nx1 = NoiseAddF(n01, NoiseMulF(u, NoiseSubF(n11, n01)));
+    return NoiseAddF(nx0, NoiseMulF(v, NoiseSubF(nx1, nx0)));
+}
+
+#endif
+
+// FractalNoise2D() at four points (x[i], z[i]), bit identical to four scalar calls
+void FractalNoise2D4(const float x[4], const float z[4], unsigned int seed, int octaves, float result[4])
+{
+#if defined(LIZARD_NOISE_SSE2) || defined(LIZARD_NOISE_WASM_SIMD)
+    NoiseFloat4 pointX = NoiseLoadF(x);
+    NoiseFloat4 pointZ = NoiseLoadF(z);
+    NoiseFloat4 sum = NoiseSetF(0.0f);
+    float amplitude = 1.0f;
+    float amplitudeSum = 0.0f;
+    float frequency = 1.0f;
+
+    for (int i = 0; i < octaves; i++)
+    {
+        NoiseFloat4 octaveX = NoiseMulF(pointX, NoiseSetF(frequency));
+        NoiseFloat4 octaveZ = NoiseMulF(pointZ, NoiseSetF(frequency));
+        sum = NoiseAddF(sum, NoiseMulF(PerlinNoise2D4(octaveX, octaveZ, seed + i), NoiseSetF(amplitude)));
+        amplitudeSum += amplitude;
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+
+    NoiseStoreF(result, NoiseDivF(sum, NoiseSetF(amplitudeSum)));
+#else
+    for (int i = 0; i < 4; i++) result[i] = FractalNoise2D(x[i], z[i], seed, octaves);
+#endif
+}
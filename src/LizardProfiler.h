@@ -0,0 +1,176 @@
+/*******************************************************************************************
+*
+*   LizardProfiler * Frame zone timings, overlay and Chrome trace export
+*
+*   PROFILE_BEGIN(zone) / PROFILE_END(zone) time a fixed set of main thread zones. Every frame
+*   UpdateProfiler() moves the zone totals into a rolling history that DrawProfiler() shows as
+*   milliseconds plus a small histogram per zone. While a capture is running every zone is also
+*   recorded as an event and SaveProfilerTrace() writes them as Chrome trace JSON (open it in
+*   chrome://tracing or ui.perfetto.dev); on web the file is downloaded from the Emscripten FS.
+*
+*   The profiler only exists when LIZARD_PROFILER is defined, debug builds define it by default.
+*   Otherwise the zone macros expand to nothing and the functions are not compiled.
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+
+#if defined(_DEBUG) && !defined(LIZARD_PROFILER)
+    #define LIZARD_PROFILER
+#endif
+
+// Profiled zones, in overlay order
+enum ProfileZone
+{
+    ProfileCamera,          // Camera update
+    ProfileChunkStreaming,  // Chunk cache loads and evictions
+    ProfileChunkRemesh,     // Scheduling remeshes, meshing itself when jobs run synchronously
+    ProfileMeshUpload,      // Uploading finished meshes to the GPU
+    ProfileDrawChunks,      // Chunk draw calls
+    ProfileBlit,            // Render texture to screen
+    ProfileZoneCount
+};
+
+#if defined(LIZARD_PROFILER)
+
+#include <stdio.h>                          // Required for: fopen(), fprintf()
+
+#if defined(PLATFORM_WEB)
+    #include <emscripten/emscripten.h>      // Required for: emscripten_run_script()
+#endif
+
+#define PROFILER_HISTORY 120                // Frames kept for the histograms
+#define MAX_PROFILER_EVENTS 65536           // Trace events kept per capture
+
+#define PROFILE_BEGIN(zone) BeginProfileZone(zone)
+#define PROFILE_END(zone) EndProfileZone(zone)
+
+typedef struct {
+    double startTime;                       // Start of the running zone, in seconds
+    double frameTime;                       // Time spent in the zone this frame, in seconds
+    float history[PROFILER_HISTORY];        // Past frame times, in milliseconds
+} ProfilerZone;
+
+typedef struct {
+    int zone;
+    double startTime;
+    double duration;
+} ProfilerEvent;
+
+static const char* profileZoneNames[ProfileZoneCount] = { "Camera", "ChunkStreaming", "ChunkRemesh", "MeshUpload", "DrawChunks", "Blit" };
+
+ProfilerZone profilerZones[ProfileZoneCount] = { 0 };
+int profilerFrame = 0;                      // Next history slot
+bool profilerOverlay = false;               // Whether DrawProfiler() draws anything
+ProfilerEvent* profilerEvents = NULL;       // Trace events, only allocated while capturing
+int profilerEventCount = 0;
+double profilerCaptureStart = 0.0;
+
+void BeginProfileZone(int zone)
+{
+    profilerZones[zone].startTime = GetTime();
+}
+
+void EndProfileZone(int zone)
+{
+    ProfilerZone* profilerZone = &profilerZones[zone];
+    double duration = GetTime() - profilerZone->startTime;
+    profilerZone->frameTime += duration;
+
+    if ((profilerEvents != NULL) && (profilerEventCount < MAX_PROFILER_EVENTS))
+    {
+        profilerEvents[profilerEventCount++] = (ProfilerEvent){ zone, profilerZone->startTime, duration };
+    }
+}
+
+// Close the frame: move this frame's zone times into the history
+void UpdateProfiler(void)
+{
+    for (int i = 0; i < ProfileZoneCount; i++)
+    {
+        profilerZones[i].history[profilerFrame] = (float)(profilerZones[i].frameTime*1000.0);
+        profilerZones[i].frameTime = 0.0;
+    }
+
+    profilerFrame = (profilerFrame + 1)%PROFILER_HISTORY;
+}
+
+// Draw the last frame's zone times and their histograms, bars are scaled so 16.6 ms fills the height
+void DrawProfiler(int posX, int posY)
+{
+    if (!profilerOverlay) return;
+
+    const int rowHeight = 20;
+    const int histogramX = posX + 150;
+    const float msToPixels = (rowHeight - 4)/16.6f;
+    int last = (profilerFrame + PROFILER_HISTORY - 1)%PROFILER_HISTORY;
+
+    DrawRectangle(posX - 4, posY - 4, 150 + PROFILER_HISTORY + 12, ProfileZoneCount*rowHeight + 20, Fade(BLACK, 0.6f));
+    DrawText((profilerEvents != NULL)? TextFormat("Profiler (F3), capturing %i events (F4)", profilerEventCount) : "Profiler (F3), F4 to capture a trace", posX, posY, 10, RAYWHITE);
+
+    for (int i = 0; i < ProfileZoneCount; i++)
+    {
+        const ProfilerZone* zone = &profilerZones[i];
+        int rowY = posY + 14 + i*rowHeight;
+
+        DrawText(TextFormat("%-14s %6.2f ms", profileZoneNames[i], zone->history[last]), posX, rowY + 5, 10, LIME);
+
+        for (int frame = 0; frame < PROFILER_HISTORY; frame++)
+        {
+            float ms = zone->history[(profilerFrame + frame)%PROFILER_HISTORY];
+            int height = (int)(ms*msToPixels + 0.5f);
+            if (height > rowHeight - 4) height = rowHeight - 4;
+            if (height > 0) DrawRectangle(histogramX + frame, rowY + rowHeight - 2 - height, 1, height, (ms > 16.6f)? RED : LIME);
+        }
+    }
+}
+
+void StartProfilerCapture(void)
+{
+    if (profilerEvents == NULL) profilerEvents = (ProfilerEvent*)MemAlloc(MAX_PROFILER_EVENTS*sizeof(ProfilerEvent));
+    profilerEventCount = 0;
+    profilerCaptureStart = GetTime();
+}
+
+// Write the captured events as Chrome trace JSON and end the capture, on web the file is also downloaded
+bool SaveProfilerTrace(const char* fileName)
+{
+    if (profilerEvents == NULL) return false;
+
+    FILE* file = fopen(fileName, "w");
+    bool success = (file != NULL);
+
+    if (success)
+    {
+        fprintf(file, "{\"traceEvents\":[\n");
+        for (int i = 0; i < profilerEventCount; i++)
+        {
+            const ProfilerEvent* event = &profilerEvents[i];
+            fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.1f,\"dur\":%.1f,\"pid\":1,\"tid\":1}%s\n", profileZoneNames[event->zone],
+                (event->startTime - profilerCaptureStart)*1e6, event->duration*1e6, (i < profilerEventCount - 1)? "," : "");
+        }
+        fprintf(file, "],\"displayTimeUnit\":\"ms\"}\n");
+        fclose(file);
+
+        TraceLog(LOG_INFO, "PROFILER: [%s] Saved %i trace events", fileName, profilerEventCount);
+#if defined(PLATFORM_WEB)
+        emscripten_run_script(TextFormat("saveFileFromMEMFSToDisk('%s','%s')", fileName, GetFileName(fileName)));
+#endif
+    }
+    else TraceLog(LOG_WARNING, "PROFILER: [%s] Failed to save trace", fileName);
+
+    MemFree(profilerEvents);
+    profilerEvents = NULL;
+    profilerEventCount = 0;
+
+    return success;
+}
+
+#else
+
+#define PROFILE_BEGIN(zone) ((void)0)
+#define PROFILE_END(zone) ((void)0)
+
+#endif
@@ -0,0 +1,514 @@
+/*******************************************************************************************
+*
+*   LizardRegionFile * Chunk columns saved to disk in region files
+*
+*   A region file holds the chunk columns of a REGION_FILE_SIZE x REGION_FILE_SIZE area:
+*     - Header:  "LZRG", format version, then an offset table with one entry per column
+*     - Columns: after the table, each one run-length compressed on its own
+*   A column is its sections' BlockStorage written one after another (mode, palette, packed data),
+*   so loading one is a decompress and a copy, no terrain generation. Integers are little endian.
+*   A saved column goes to the first gap left by earlier saves that fits it, and only to the end of
+*   the file when none does, so resaving keeps the file compact. Its current bytes are never written
+*   over: the table entry is repointed after the new copy is written, so a save cut short keeps the
+*   old copy.
+*
+*   On desktop POSIX systems region files are read through mmap and only the columns asked for are
+*   copied out, everything else stays untouched on disk. Elsewhere the same reads use stdio. On web
+*   the save directory is an IndexedDB backed Emscripten filesystem (link with -lidbfs.js): its files
+*   are pulled in when InitRegionFiles() is called and written back every few seconds after a save.
+*   Region files are main thread only, EncodeChunkColumn()/DecodeChunkColumn() are safe anywhere.
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+#include "LizardBlockWorld.h"
+
+#include <stdio.h>                          // Required for: FILE, fopen(), fread(), fwrite(), snprintf()
+#include <string.h>                         // Required for: memcpy(), memcmp()
+#include <stdlib.h>                         // Required for: qsort()
+
+#if defined(PLATFORM_WEB)
+    #include <emscripten/emscripten.h>      // Required for: EM_ASM(), EMSCRIPTEN_KEEPALIVE
+#elif defined(__unix__) || defined(__APPLE__)
+    #define LIZARD_REGION_MMAP
+    #include <sys/mman.h>                   // Required for: mmap(), munmap()
+#endif
+
+#define REGION_FILE_SIZE 32                 // Chunk columns per region file side
+#define REGION_FILE_CHUNKS (REGION_FILE_SIZE * REGION_FILE_SIZE)
+#define REGION_FILE_VERSION 1
+#define MAX_OPEN_REGION_FILES 8             // Region files kept open, the least recently used one is closed first
+#define MAX_CHUNK_COLUMN_BYTES (CHUNK_SECTIONS * (CHUNK_VOLUME + MAX_BLOCK_PALETTE + 3)) // Uncompressed column, worst case
+#define REGION_SYNC_INTERVAL 5.0            // Seconds between IndexedDB writes on web
+#define REGION_HEADER_SIZE (8 + REGION_FILE_CHUNKS * 8) // Magic, version and the offset table
+
+// Where a column is stored in its region file, offset 0 if it has not been saved
+typedef struct {
+    unsigned int offset;
+    unsigned int size;
+} RegionChunkEntry;
+
+typedef struct {
+    bool open;
+    int regionX, regionZ;                   // Region coordinate, in REGION_FILE_SIZE chunks
+    FILE* file;
+    unsigned int fileSize;
+    unsigned int lastUsed;                  // regionFileClock at the last access
+    RegionChunkEntry table[REGION_FILE_CHUNKS];
+#if defined(LIZARD_REGION_MMAP)
+    unsigned char* map;                     // Read only view of the file, NULL if not mapped yet
+    size_t mapSize;
+#endif
+} RegionFile;
+
+static const char regionFileMagic[4] = { 'L', 'Z', 'R', 'G' };
+
+RegionFile regionFiles[MAX_OPEN_REGION_FILES] = { 0 };
+char regionDirectory[256] = { 0 };
+unsigned int regionFileClock = 0;
+bool regionFilesReady = false;              // False until the save directory can be used (web: IndexedDB loaded)
+bool regionFilesWritten = false;            // Web: files changed since the last IndexedDB write
+double regionSyncTime = 0.0;
+
+#if defined(PLATFORM_WEB)
+EMSCRIPTEN_KEEPALIVE void OnRegionFilesLoaded(void)
+{
+    regionFilesReady = true;
+    TraceLog(LOG_INFO, "REGION: [%s] Save files loaded", regionDirectory);
+}
+#endif
+
+// Set the directory region files live in and create it if needed. NULL keeps every column in memory only,
+// nothing is read or saved (benchmarks)
+void InitRegionFiles(const char* directory)
+{
+    if (directory == NULL)
+    {
+        regionDirectory[0] = '\0';
+        regionFilesReady = true;
+        return;
+    }
+    snprintf(regionDirectory, sizeof(regionDirectory), "%s", directory);
+
+#if defined(PLATFORM_WEB)
+    // Mount IndexedDB and pull the saved files in, nothing is read or written until that finishes
+    EM_ASM({
+        var path = UTF8ToString($0);
+        FS.mkdir(path);
+        FS.mount(IDBFS, {}, path);
+        FS.syncfs(true, function(error) { Module._OnRegionFilesLoaded(); });
+    }, regionDirectory);
+#else
+    if (!DirectoryExists(regionDirectory)) MakeDirectory(regionDirectory);
+    regionFilesReady = true;
+#endif
+}
+
+// Little endian integers of the file header, whatever the host byte order
+void WriteRegionInt(unsigned char* bytes, unsigned int value)
+{
+    bytes[0] = (unsigned char)value;
+    bytes[1] = (unsigned char)(value >> 8);
+    bytes[2] = (unsigned char)(value >> 16);
+    bytes[3] = (unsigned char)(value >> 24);
+}
+
+unsigned int ReadRegionInt(const unsigned char* bytes)
+{
+    return (unsigned int)bytes[0] | ((unsigned int)bytes[1] << 8) | ((unsigned int)bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+}
+
+// Round down to a region coordinate
+int GetRegionCoordinate(int chunkCoordinate)
+{
+    return (chunkCoordinate >= 0) ? chunkCoordinate / REGION_FILE_SIZE : (chunkCoordinate + 1) / REGION_FILE_SIZE - 1;
+}
+
+void CloseRegionFile(RegionFile* region)
+{
+#if defined(LIZARD_REGION_MMAP)
+    if (region->map != NULL) munmap(region->map, region->mapSize);
+#endif
+    fclose(region->file);
+    *region = (RegionFile){ 0 };
+}
+
+// Get the open region file of a chunk column, opening it if needed. Returns NULL if the file does not exist
+// and create is false, or if it cannot be used.
+RegionFile* GetRegionFile(int chunkX, int chunkZ, bool create)
+{
+    if (!regionFilesReady || (regionDirectory[0] == '\0')) return NULL;
+
+    int regionX = GetRegionCoordinate(chunkX);
+    int regionZ = GetRegionCoordinate(chunkZ);
+    RegionFile* slot = &regionFiles[0];
+    regionFileClock++;
+
+    for (int i = 0; i < MAX_OPEN_REGION_FILES; i++)
+    {
+        RegionFile* region = &regionFiles[i];
+        if (region->open && region->regionX == regionX && region->regionZ == regionZ)
+        {
+            region->lastUsed = regionFileClock;
+            return region;
+        }
+
+        // Reuse a closed slot, or else the least recently used one
+        if (slot->open && (!region->open || region->lastUsed < slot->lastUsed)) slot = region;
+    }
+
+    const char* fileName = TextFormat("%s/r.%i.%i.lzr", regionDirectory, regionX, regionZ);
+    FILE* file = fopen(fileName, "r+b");
+    if (file == NULL && !create) return NULL;
+
+    if (slot->open) CloseRegionFile(slot);
+    *slot = (RegionFile){ 0 };
+    slot->regionX = regionX;
+    slot->regionZ = regionZ;
+    slot->lastUsed = regionFileClock;
+
+    unsigned char* header = (unsigned char*)MemAlloc(REGION_HEADER_SIZE);
+
+    if (file == NULL)
+    {
+        // New region: header with an empty table
+        file = fopen(fileName, "w+b");
+        memcpy(header, regionFileMagic, 4);
+        WriteRegionInt(&header[4], REGION_FILE_VERSION);
+        if (file == NULL || fwrite(header, REGION_HEADER_SIZE, 1, file) != 1)
+        {
+            MemFree(header);
+            TraceLog(LOG_WARNING, "REGION: [%s] Failed to create region file", fileName);
+            if (file != NULL) fclose(file);
+            return NULL;
+        }
+        fflush(file);
+    }
+    else
+    {
+        if (fread(header, REGION_HEADER_SIZE, 1, file) != 1 || memcmp(header, regionFileMagic, 4) != 0 || ReadRegionInt(&header[4]) != REGION_FILE_VERSION)
+        {
+            TraceLog(LOG_WARNING, "REGION: [%s] Not a region file of version %i, ignored", fileName, REGION_FILE_VERSION);
+            MemFree(header);
+            fclose(file);
+            return NULL;
+        }
+
+        for (int i = 0; i < REGION_FILE_CHUNKS; i++)
+        {
+            slot->table[i].offset = ReadRegionInt(&header[8 + i * 8]);
+            slot->table[i].size = ReadRegionInt(&header[8 + i * 8 + 4]);
+        }
+    }
+    MemFree(header);
+
+    fseek(file, 0, SEEK_END);
+    slot->fileSize = (unsigned int)ftell(file);
+    slot->file = file;
+    slot->open = true;
+    return slot;
+}
+
+// Copy the saved bytes of a chunk column out of its region file. Returns NULL if the column was never saved,
+// free the result with MemFree().
+unsigned char* ReadRegionChunk(int chunkX, int chunkZ, int* size)
+{
+    RegionFile* region = GetRegionFile(chunkX, chunkZ, false);
+    if (region == NULL) return NULL;
+
+    int localX = chunkX - region->regionX * REGION_FILE_SIZE;
+    int localZ = chunkZ - region->regionZ * REGION_FILE_SIZE;
+    RegionChunkEntry entry = region->table[localX * REGION_FILE_SIZE + localZ];
+    if (entry.offset == 0) return NULL;
+
+    // A corrupt table must not point into the header or past the end of the file
+    if (entry.offset < REGION_HEADER_SIZE || entry.size > region->fileSize || entry.offset > region->fileSize - entry.size) return NULL;
+
+    unsigned char* data = (unsigned char*)MemAlloc(entry.size);
+
+#if defined(LIZARD_REGION_MMAP)
+    // Map the file again when columns were appended past the current view
+    if (region->map == NULL || entry.offset + entry.size > region->mapSize)
+    {
+        if (region->map != NULL) munmap(region->map, region->mapSize);
+        region->mapSize = region->fileSize;
+        region->map = (unsigned char*)mmap(NULL, region->mapSize, PROT_READ, MAP_SHARED, fileno(region->file), 0);
+        if (region->map == MAP_FAILED) region->map = NULL;
+    }
+
+    if (region->map != NULL)
+    {
+        memcpy(data, region->map + entry.offset, entry.size);
+        *size = (int)entry.size;
+        return data;
+    }
+#endif
+
+    fseek(region->file, (long)entry.offset, SEEK_SET);
+    if (fread(data, entry.size, 1, region->file) != 1)
+    {
+        MemFree(data);
+        return NULL;
+    }
+
+    *size = (int)entry.size;
+    return data;
+}
+
+int CompareRegionChunkEntries(const void* a, const void* b)
+{
+    unsigned int offsetA = ((const RegionChunkEntry*)a)->offset;
+    unsigned int offsetB = ((const RegionChunkEntry*)b)->offset;
+    return (offsetA > offsetB) - (offsetA < offsetB);
+}
+
+// Offset to store size bytes of a column at: the first gap between the saved columns that fits, else right after
+// the last saved column. The column's own current bytes stay in use until its table entry points elsewhere.
+unsigned int FindRegionSpace(const RegionFile* region, unsigned int size)
+{
+    RegionChunkEntry used[REGION_FILE_CHUNKS];
+    int usedCount = 0;
+    for (int i = 0; i < REGION_FILE_CHUNKS; i++)
+    {
+        if (region->table[i].offset != 0) used[usedCount++] = region->table[i];
+    }
+    qsort(used, usedCount, sizeof(RegionChunkEntry), CompareRegionChunkEntries);
+
+    unsigned int end = REGION_HEADER_SIZE;
+    for (int i = 0; i < usedCount; i++)
+    {
+        if (used[i].offset >= end && used[i].offset - end >= size) return end;
+        if (used[i].offset + used[i].size > end) end = used[i].offset + used[i].size;
+    }
+
+    return end;
+}
+
+// Write a chunk column's bytes to its region file and point the offset table at them
+bool WriteRegionChunk(int chunkX, int chunkZ, const unsigned char* data, int size)
+{
+    RegionFile* region = GetRegionFile(chunkX, chunkZ, true);
+    if (region == NULL) return false;
+
+    int index = (chunkX - region->regionX * REGION_FILE_SIZE) * REGION_FILE_SIZE + (chunkZ - region->regionZ * REGION_FILE_SIZE);
+    RegionChunkEntry entry = { FindRegionSpace(region, (unsigned int)size), (unsigned int)size };
+
+    fseek(region->file, (long)entry.offset, SEEK_SET);
+    bool success = (fwrite(data, size, 1, region->file) == 1);
+
+    if (success)
+    {
+        unsigned char bytes[8];
+        WriteRegionInt(&bytes[0], entry.offset);
+        WriteRegionInt(&bytes[4], entry.size);
+        fseek(region->file, 8 + index * 8L, SEEK_SET);
+        success = (fwrite(bytes, sizeof(bytes), 1, region->file) == 1);
+    }
+    fflush(region->file);
+
+    if (!success)
+    {
+        TraceLog(LOG_WARNING, "REGION: Failed to save chunk column (%i, %i)", chunkX, chunkZ);
+        return false;
+    }
+
+    region->table[index] = entry;
+    if (entry.offset + entry.size > region->fileSize) region->fileSize = entry.offset + entry.size;
+    regionFilesWritten = true;
+    return true;
+}
+
+void CloseRegionFiles(void)
+{
+    for (int i = 0; i < MAX_OPEN_REGION_FILES; i++)
+    {
+        if (regionFiles[i].open) CloseRegionFile(&regionFiles[i]);
+    }
+}
+
+// Web: write changed files back to IndexedDB, at most every REGION_SYNC_INTERVAL seconds unless forced
+void UpdateRegionFiles(bool force)
+{
+#if defined(PLATFORM_WEB)
+    if (!regionFilesReady || !regionFilesWritten) return;
+    if (!force && GetTime() - regionSyncTime < REGION_SYNC_INTERVAL) return;
+
+    for (int i = 0; i < MAX_OPEN_REGION_FILES; i++)
+    {
+        if (regionFiles[i].open) fflush(regionFiles[i].file);
+    }
+    EM_ASM({ FS.syncfs(false, function(error) { if (error) console.warn("REGION: IndexedDB write failed", error); }); });
+    regionFilesWritten = false;
+    regionSyncTime = GetTime();
+#else
+    (void)force;
+#endif
+}
+
+// Run-length compress: a control byte n < 128 is followed by n + 1 literal bytes, n >= 128 by one byte repeated
+// n - 125 times. Output needs room for size + size/128 + 1 bytes, returns the compressed size.
+int CompressRunLength(const unsigned char* data, int size, unsigned char* output)
+{
+    int in = 0;
+    int out = 0;
+
+    while (in < size)
+    {
+        int run = 1;
+        while (in + run < size && run < 130 && data[in + run] == data[in]) run++;
+
+        if (run >= 3)
+        {
+            output[out++] = (unsigned char)(run + 125);
+            output[out++] = data[in];
+            in += run;
+            continue;
+        }
+
+        // Literals up to the next run of three
+        int start = in;
+        while (in < size && in - start < 128)
+        {
+            if (in + 2 < size && data[in] == data[in + 1] && data[in] == data[in + 2]) break;
+            in++;
+        }
+        output[out++] = (unsigned char)(in - start - 1);
+        memcpy(&output[out], &data[start], in - start);
+        out += in - start;
+    }
+
+    return out;
+}
+
+// Undo CompressRunLength(), returns the decompressed size or -1 if the data is corrupt or does not fit
+int DecompressRunLength(const unsigned char* data, int size, unsigned char* output, int capacity)
+{
+    int in = 0;
+    int out = 0;
+
+    while (in < size)
+    {
+        int control = data[in++];
+
+        if (control >= 128)
+        {
+            int run = control - 125;
+            if (in >= size || out + run > capacity) return -1;
+            memset(&output[out], data[in++], run);
+            out += run;
+        }
+        else
+        {
+            int count = control + 1;
+            if (in + count > size || out + count > capacity) return -1;
+            memcpy(&output[out], &data[in], count);
+            in += count;
+            out += count;
+        }
+    }
+
+    return out;
+}
+
+// Serialize and compress the sections of a chunk column, bottom to top. Free the result with MemFree().
+unsigned char* EncodeChunkColumn(const BlockStorage* const sections[CHUNK_SECTIONS], int* size)
+{
+    unsigned char* raw = (unsigned char*)MemAlloc(MAX_CHUNK_COLUMN_BYTES);
+    int rawSize = 0;
+
+    for (int i = 0; i < CHUNK_SECTIONS; i++)
+    {
+        const BlockStorage* storage = sections[i];
+        raw[rawSize++] = (unsigned char)storage->mode;
+
+        if (storage->mode == BlockStorageSingle) raw[rawSize++] = storage->singleType;
+        else if (storage->mode == BlockStoragePalette)
+        {
+            raw[rawSize++] = (unsigned char)storage->paletteCount;
+            raw[rawSize++] = (unsigned char)storage->bitsPerIndex;
+            memcpy(&raw[rawSize], storage->palette, storage->paletteCount);
+            rawSize += storage->paletteCount;
+
+            memcpy(&raw[rawSize], storage->data, GetBlockStorageSize(storage));
+            rawSize += GetBlockStorageSize(storage);
+        }
+        else
+        {
+            memcpy(&raw[rawSize], storage->data, CHUNK_VOLUME);
+            rawSize += CHUNK_VOLUME;
+        }
+    }
+
+    unsigned char* compressed = (unsigned char*)MemAlloc(rawSize + rawSize / 128 + 1);
+    *size = CompressRunLength(raw, rawSize, compressed);
+    MemFree(raw);
+
+    return compressed;
+}
+
+// Replace the sections of a chunk column with saved data, returns false (sections untouched) if it is corrupt,
+// block types that are not registered included
+bool DecodeChunkColumn(const unsigned char* data, int size, BlockStorage* const sections[CHUNK_SECTIONS])
+{
+    unsigned char* raw = (unsigned char*)MemAlloc(MAX_CHUNK_COLUMN_BYTES);
+    int rawSize = DecompressRunLength(data, size, raw, MAX_CHUNK_COLUMN_BYTES);
+    BlockStorage decoded[CHUNK_SECTIONS] = { 0 };
+    int read = 0;
+    bool valid = (rawSize > 0);
+
+    for (int i = 0; i < CHUNK_SECTIONS && valid; i++)
+    {
+        BlockStorage* storage = &decoded[i];
+        valid = (read + 2 <= rawSize);
+        if (!valid) break;
+
+        storage->mode = raw[read++];
+        if (storage->mode == BlockStorageSingle)
+        {
+            storage->singleType = raw[read++];
+            valid = (storage->singleType < blockTypeCount);
+        }
+        else if (storage->mode == BlockStoragePalette)
+        {
+            storage->paletteCount = raw[read++];
+            storage->bitsPerIndex = (read < rawSize) ? raw[read++] : 0;
+            valid = (storage->paletteCount >= 2 && storage->paletteCount <= (1 << storage->bitsPerIndex) && storage->paletteCount <= MAX_BLOCK_PALETTE &&
+                (storage->bitsPerIndex == 1 || storage->bitsPerIndex == 2 || storage->bitsPerIndex == 4) && read + storage->paletteCount <= rawSize);
+            if (!valid) break;
+
+            memcpy(storage->palette, &raw[read], storage->paletteCount);
+            read += storage->paletteCount;
+            for (int p = 0; p < storage->paletteCount && valid; p++) valid = (storage->palette[p] < blockTypeCount);
+        }
+        else valid = (storage->mode == BlockStorageDirect);
+
+        int dataSize = valid ? GetBlockStorageSize(storage) : 0;
+        valid = valid && (read + dataSize <= rawSize);
+        if (valid && storage->mode == BlockStorageDirect)
+        {
+            for (int b = 0; b < dataSize && valid; b++) valid = (raw[read + b] < blockTypeCount);
+        }
+        if (valid && dataSize > 0)
+        {
+            storage->data = (unsigned char*)MemAlloc(dataSize);
+            memcpy(storage->data, &raw[read], dataSize);
+            read += dataSize;
+        }
+    }
+
+    valid = valid && (read == rawSize);
+    for (int i = 0; i < CHUNK_SECTIONS; i++)
+    {
+        if (valid)
+        {
+            FreeBlockStorage(sections[i]);
+            *sections[i] = decoded[i];
+        }
+        else FreeBlockStorage(&decoded[i]);
+    }
+
+    MemFree(raw);
+    return valid;
+}
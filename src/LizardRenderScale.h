@@ -0,0 +1,108 @@
+/*******************************************************************************************
+*
+*   LizardRenderScale * Dynamic resolution for the offscreen scene render
+*
+*   The scene is drawn into the top left renderScale part of a fixed size render texture and
+*   stretched over the screen, so lowering the scale costs no reallocation. Every frame
+*   BeginRenderScaleFrame() measures the interval since the previous frame and EndRenderScaleFrame()
+*   the CPU time spent on it, both smoothed over a few frames. rlgl has no GPU timer queries, so GPU
+*   load shows up the way it stalls the game: in the buffer swap, making the interval miss the budget
+*   while the CPU time is still inside it. Then the scale steps down. Once frames keep the budget with
+*   CPU time to spare for a while it steps back up. A frame that misses because of the CPU is left
+*   alone, a smaller render would not help it.
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+
+#define RENDER_SCALE_MIN 0.5f               // Smallest render scale, of each axis
+#define RENDER_SCALE_STEP 0.05f             // Scale change per adjustment
+#define RENDER_SCALE_SETTLE_FRAMES 10       // Frames between adjustments, for the averages to catch up
+#define RENDER_SCALE_LOWER_FRAMES 10        // GPU bound frames in a row before the scale goes down
+#define RENDER_SCALE_RAISE_FRAMES 120       // Frames in a row with headroom before the scale goes up
+
+// Upscale filter, the filterMode uniform of pixel.fs
+enum RenderFilter
+{
+    RenderFilterNearest,
+    RenderFilterBilinear,
+};
+
+float renderScale = 1.0f;                   // Part of the render texture the scene is drawn to, of each axis
+bool renderScaleAuto = true;                // Whether the scale follows the frame time, otherwise it stays at 1
+int renderFilter = RenderFilterBilinear;
+float frameTimeBudget = 1.0f/60.0f;         // Frame interval to hold, in seconds
+
+double renderScaleFrameStart = 0.0;
+float frameIntervalAverage = 0.0f;          // Smoothed time between frames, in seconds
+float frameCpuAverage = 0.0f;               // Smoothed CPU time of a frame, without the buffer swap
+int renderScaleSettleFrames = 0;            // Frames left before the next adjustment may happen
+int renderScaleGpuBoundFrames = 0;          // Frames in a row that missed the budget outside the CPU
+int renderScaleHeadroomFrames = 0;          // Frames in a row with time to spare
+
+// Call first thing in a frame
+void BeginRenderScaleFrame(void)
+{
+    double now = GetTime();
+    if (renderScaleFrameStart > 0.0)
+    {
+        float interval = (float)(now - renderScaleFrameStart);
+        frameIntervalAverage = (frameIntervalAverage == 0.0f) ? interval : frameIntervalAverage + (interval - frameIntervalAverage)*0.1f;
+    }
+    renderScaleFrameStart = now;
+}
+
+// Call right before EndDrawing(), adjusts renderScale for the next frame
+void EndRenderScaleFrame(void)
+{
+    float cpuTime = (float)(GetTime() - renderScaleFrameStart);
+    frameCpuAverage = (frameCpuAverage == 0.0f) ? cpuTime : frameCpuAverage + (cpuTime - frameCpuAverage)*0.1f;
+
+    if (!renderScaleAuto)
+    {
+        renderScale = 1.0f;
+        return;
+    }
+    if (renderScaleSettleFrames > 0)
+    {
+        renderScaleSettleFrames--;
+        return;
+    }
+
+    bool missed = (frameIntervalAverage > frameTimeBudget*1.1f);
+    bool gpuBound = missed && (frameCpuAverage < frameTimeBudget*0.9f);
+    bool headroom = !missed && (frameCpuAverage < frameTimeBudget*0.7f);
+
+    renderScaleGpuBoundFrames = gpuBound ? renderScaleGpuBoundFrames + 1 : 0;
+    renderScaleHeadroomFrames = headroom ? renderScaleHeadroomFrames + 1 : 0;
+
+    float scale = renderScale;
+    if (renderScaleGpuBoundFrames >= RENDER_SCALE_LOWER_FRAMES) scale -= RENDER_SCALE_STEP;
+    else if (renderScaleHeadroomFrames >= RENDER_SCALE_RAISE_FRAMES) scale += RENDER_SCALE_STEP;
+
+    if (scale < RENDER_SCALE_MIN) scale = RENDER_SCALE_MIN;
+    if (scale > 1.0f) scale = 1.0f;
+
+    if (scale != renderScale)
+    {
+        renderScale = scale;
+        renderScaleSettleFrames = RENDER_SCALE_SETTLE_FRAMES;
+        renderScaleGpuBoundFrames = 0;
+        renderScaleHeadroomFrames = 0;
+    }
+}
+
+// Size of the part of a render texture the scene is drawn to at the current scale
+int GetRenderScaleWidth(RenderTexture2D target)
+{
+    int width = (int)(target.texture.width*renderScale + 0.5f);
+    return (width > 0) ? width : 1;
+}
+
+int GetRenderScaleHeight(RenderTexture2D target)
+{
+    int height = (int)(target.texture.height*renderScale + 0.5f);
+    return (height > 0) ? height : 1;
+}
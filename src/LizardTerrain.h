@@ -0,0 +1,80 @@
+/*******************************************************************************************
+*
+*   LizardTerrain * Procedural terrain for chunk columns
+*
+*   Column heights come from fractal Perlin noise (LizardNoise.h), every column is filled with
+*   stone, three layers of dirt and a grass top, with air above. Nothing here touches the GPU,
+*   so the game's workers and the headless benchmark share it.
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+#include "raymath.h"                        // Required for: Clamp()
+#include "LizardBlockWorld.h"
+#include "LizardNoise.h"
+
+// Scale factors
+float scale = CHUNK_SIZE; // Adjust scale for the noise
+float heightScale = 64; // Maximum height for your terrain, must stay below WORLD_HEIGHT
+float noiseFrequency = 1.0f / 48.0f; // Terrain noise frequency, in cycles per block
+int noiseOctaves = 4;
+unsigned int worldSeed = 1337;
+// Get height using fractal Perlin noise at any world column
+float GetHeight(int x, int z) {
+    float heightValue = FractalNoise2D(x * noiseFrequency, z * noiseFrequency, worldSeed, noiseOctaves) * 0.5f + 0.5f;
+    return Clamp(heightValue, 0.0f, 1.0f) * heightScale;
+}
+// Function to sample the terrain height of every block column of a chunk column, in blocks.
+// Columns are evaluated four at a time (FractalNoise2D4) and match GetHeight() exactly.
+void GetTerrainHeights(int chunkX, int chunkZ, int heights[CHUNK_SIZE][CHUNK_SIZE]) {
+    for (int bx = 0; bx < CHUNK_SIZE; bx++) {
+        for (int bz = 0; bz < CHUNK_SIZE; bz += 4) {
+            // Calculate world coordinates
+            int worldX = chunkX * CHUNK_SIZE + bx;
+            int worldZ = chunkZ * CHUNK_SIZE + bz;
+            float x[4] = { worldX * noiseFrequency, worldX * noiseFrequency, worldX * noiseFrequency, worldX * noiseFrequency };
+            float z[4] = { worldZ * noiseFrequency, (worldZ + 1) * noiseFrequency, (worldZ + 2) * noiseFrequency, (worldZ + 3) * noiseFrequency };
+            float noise[4];
+
+            FractalNoise2D4(x, z, worldSeed, noiseOctaves, noise);
+            for (int i = 0; i < 4; i++) heights[bx][bz + i] = (int)(Clamp(noise[i] * 0.5f + 0.5f, 0.0f, 1.0f) * heightScale);
+        }
+    }
+}
+// Function to fill one section of a chunk column with blocks from its terrain heights (see GetTerrainHeights),
+// safe to call from worker threads
+void GenerateTerrainSection(BlockStorage* blocks, const int heights[CHUNK_SIZE][CHUNK_SIZE], int sectionY) {
+
+    unsigned char types[CHUNK_VOLUME];
+
+    for (int bx = 0; bx < CHUNK_SIZE; bx++) {
+        for (int bz = 0; bz < CHUNK_SIZE; bz++) {
+            int heightInt = heights[bx][bz];
+
+            for (int by = 0; by < CHUNK_SIZE; by++) {
+                int worldY = sectionY * CHUNK_SIZE + by;
+
+                // Set block types based on height
+                if (worldY < heightInt)
+                {
+                    if (worldY == heightInt - 1) {
+                        types[BLOCK_INDEX(bx, by, bz)] = Grass; // Top layer
+                    }
+                    else if (worldY >= heightInt - 3) {
+                        types[BLOCK_INDEX(bx, by, bz)] = Dirt; // Below top layer
+                    }
+                    else {
+                        types[BLOCK_INDEX(bx, by, bz)] = Stone; // Lower layers
+                    }
+                }
+                else {
+                    types[BLOCK_INDEX(bx, by, bz)] = Air; // Air above the terrain
+                }
+            }
+        }
+    }
+
+    EncodeBlockStorage(blocks, types);
+}
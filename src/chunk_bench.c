@@ -0,0 +1,395 @@
+/*******************************************************************************************
+*
+*   chunk_bench * Headless benchmark of terrain generation and chunk meshing
+*
+*   Builds worlds of several sizes and block distributions with the game's own terrain and
+*   meshing code (LizardTerrain.h, LizardChunkMesh.h) and times them on the CPU, no window or
+*   GL context is created. Every section goes through the same steps as in the game: all-air
+*   and buried sections are skipped, the rest are padded with their neighbours and meshed.
+*
+*   Build with `make bench`, run `chunk_bench [output.csv] [raycast.csv]`. Results are written as CSV
+*   (one row per distribution, world size and meshing mode) to the given file or to stdout.
+*   A "chunk" in the results is one CHUNK_SIZE^3 section.
+*
+*   A second table compares block picking: RaycastBlocks() (LizardBlockRaycast.h) against raylib's
+*   GetRayCollisionMesh() over the greedy chunk meshes of the same world, with a bounding box test
+*   before every mesh. It goes to the second file, or after the first table.
+*
+********************************************************************************************/
+
+#include "raylib.h"
+#include "LizardBlockWorld.h"
+#include "LizardJobs.h"
+#include "LizardTerrain.h"
+#include "LizardChunkMesh.h"
+#include "LizardBlockRaycast.h"
+
+#include <stdio.h>                          // Required for: fprintf(), fopen()
+#include <stdlib.h>                         // Required for: qsort()
+#include <time.h>                           // Required for: clock_gettime(), clock()
+
+#define BENCH_ROUNDS 3                      // Meshing passes over every world, more samples for the percentiles
+#define BENCH_RAYS 2000                     // Rays cast by the picking comparison
+#define BENCH_RAY_DISTANCE 256.0f           // Reach of the picking rays, in blocks
+
+// Block distributions
+enum BenchDistribution
+{
+    BenchFlat,          // Flat ground at a quarter of the world height
+    BenchNoisy,         // The game's terrain generator
+    BenchCheckerboard,  // Alternating stone and air, the worst case for both meshers
+    BenchEmpty,         // Air only
+    BenchDistributionCount
+};
+
+static const char* benchDistributionNames[BenchDistributionCount] = { "flat", "noisy", "checkerboard", "empty" };
+static const int benchWorldSizes[] = { 4, 8, 16 };  // World sizes, in chunk columns per side
+static const BlockStorage benchFloorBlocks = { BlockStorageSingle, Stone };   // Below the world is solid, as in the game
+
+// World of size x size chunk columns, CHUNK_SECTIONS sections each
+typedef struct {
+    BlockStorage* sections;
+    int size;
+} BenchWorld;
+
+// Monotonic time in seconds
+static double GetBenchTime(void)
+{
+#if defined(CLOCK_MONOTONIC)
+    struct timespec now = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec*1e-9;
+#else
+    return (double)clock()/CLOCKS_PER_SEC;
+#endif
+}
+
+static BlockStorage* GetBenchSection(BenchWorld* world, int x, int sectionY, int z)
+{
+    if ((x < 0) || (x >= world->size) || (z < 0) || (z >= world->size) || (sectionY < 0) || (sectionY >= CHUNK_SECTIONS)) return NULL;
+    return &world->sections[(x*world->size + z)*CHUNK_SECTIONS + sectionY];
+}
+
+// Fill a world with a distribution, returns the time spent in seconds
+static double GenerateBenchWorld(BenchWorld* world, int distribution)
+{
+    unsigned char types[CHUNK_VOLUME] = { 0 };
+    int heights[CHUNK_SIZE][CHUNK_SIZE] = { 0 };
+    double startTime = GetBenchTime();
+
+    for (int x = 0; x < world->size; x++)
+    {
+        for (int z = 0; z < world->size; z++)
+        {
+            if (distribution == BenchNoisy) GetTerrainHeights(x, z, heights);
+            else if (distribution == BenchFlat)
+            {
+                for (int bx = 0; bx < CHUNK_SIZE; bx++)
+                {
+                    for (int bz = 0; bz < CHUNK_SIZE; bz++) heights[bx][bz] = WORLD_HEIGHT/4;
+                }
+            }
+
+            for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++)
+            {
+                BlockStorage* blocks = GetBenchSection(world, x, sectionY, z);
+
+                switch (distribution)
+                {
+                    case BenchFlat:
+                    case BenchNoisy: GenerateTerrainSection(blocks, heights, sectionY); break;
+                    case BenchCheckerboard:
+                    {
+                        for (int i = 0; i < CHUNK_VOLUME; i++)
+                        {
+                            int bx = i/(CHUNK_SIZE*CHUNK_SIZE);
+                            int by = (i/CHUNK_SIZE)%CHUNK_SIZE;
+                            int bz = i%CHUNK_SIZE;
+                            types[i] = ((bx + by + bz)%2 == 0)? Stone : Air;
+                        }
+                        EncodeBlockStorage(blocks, types);
+                    } break;
+                    default:
+                    {
+                        memset(types, Air, CHUNK_VOLUME);
+                        EncodeBlockStorage(blocks, types);
+                    } break;
+                }
+            }
+        }
+    }
+
+    return GetBenchTime() - startTime;
+}
+
+static BenchWorld* raycastWorld = NULL;    // World read by GetBenchBlock()
+
+// Block at a world block coordinate of raycastWorld, for RaycastBlocks()
+static unsigned char GetBenchBlock(int x, int y, int z)
+{
+    if (y < 0) return Stone;
+
+    BlockStorage* blocks = GetBenchSection(raycastWorld, (x >= 0)? x/CHUNK_SIZE : -1, y/CHUNK_SIZE, (z >= 0)? z/CHUNK_SIZE : -1);
+    if (blocks == NULL) return Air;
+    return GetBlockType(blocks, x%CHUNK_SIZE, y%CHUNK_SIZE, z%CHUNK_SIZE);
+}
+
+// Compare RaycastBlocks() with GetRayCollisionMesh() over the chunk meshes of a noisy world
+static void RunRaycastBench(FILE* output)
+{
+    BenchWorld world = { 0 };
+    world.size = 8;
+    int sectionCount = world.size*world.size*CHUNK_SECTIONS;
+    world.sections = (BlockStorage*)MemAlloc(sectionCount*sizeof(BlockStorage));
+    GenerateBenchWorld(&world, BenchNoisy);
+    raycastWorld = &world;
+
+    // Greedy mesh every section into a raylib mesh in world space, two triangles per quad
+    Mesh* meshes = (Mesh*)MemAlloc(sectionCount*sizeof(Mesh));
+    BoundingBox* boxes = (BoundingBox*)MemAlloc(sectionCount*sizeof(BoundingBox));
+    int meshCount = 0;
+    long long triangleCount = 0;
+    unsigned char padded[PADDED_CHUNK_VOLUME];
+    unsigned char light[PADDED_CHUNK_VOLUME];
+    memset(light, FULL_SKY_LIGHT, sizeof(light));
+
+    for (int x = 0; x < world.size; x++)
+    {
+        for (int z = 0; z < world.size; z++)
+        {
+            for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++)
+            {
+                const BlockStorage* neighbours[6];
+                for (int f = 0; f < 6; f++)
+                {
+                    const FaceDirection* face = &faceDirections[f];
+                    if (sectionY + face->dy < 0) neighbours[f] = &benchFloorBlocks;
+                    else neighbours[f] = GetBenchSection(&world, x + face->dx, sectionY + face->dy, z + face->dz);
+                }
+
+                ChunkMeshBuilder builder = { 0 };
+                PadChunkSection(GetBenchSection(&world, x, sectionY, z), neighbours, 0, padded);
+                BuildChunkMesh(padded, light, MeshingGreedy, &builder);
+                if (builder.vertexCount == 0) continue;
+
+                Mesh* mesh = &meshes[meshCount];
+                *mesh = (Mesh){ 0 };
+                mesh->vertexCount = builder.vertexCount;
+                mesh->triangleCount = builder.vertexCount/2;
+                mesh->vertices = (float*)MemAlloc(builder.vertexCount*3*sizeof(float));
+                mesh->indices = (unsigned short*)MemAlloc(mesh->triangleCount*3*sizeof(unsigned short));
+
+                Vector3 origin = { (float)(x*CHUNK_SIZE), (float)(sectionY*CHUNK_SIZE), (float)(z*CHUNK_SIZE) };
+                for (int i = 0; i < builder.vertexCount; i++)
+                {
+                    mesh->vertices[i*3 + 0] = origin.x + builder.vertices[i].x;
+                    mesh->vertices[i*3 + 1] = origin.y + builder.vertices[i].y;
+                    mesh->vertices[i*3 + 2] = origin.z + builder.vertices[i].z;
+                }
+                for (int quad = 0; quad < builder.vertexCount/4; quad++)
+                {
+                    static const int quadIndices[6] = { 0, 1, 2, 0, 2, 3 };
+                    for (int i = 0; i < 6; i++) mesh->indices[quad*6 + i] = (unsigned short)(quad*4 + quadIndices[i]);
+                }
+
+                boxes[meshCount] = (BoundingBox){ origin, Vector3AddValue(origin, CHUNK_SIZE) };
+                triangleCount += mesh->triangleCount;
+                meshCount++;
+                MemFree(builder.vertices);
+            }
+        }
+    }
+
+    // Rays from above the terrain, looking down at the ground at random angles. Positions are not on block
+    // fractions, rays through block edges and corners can be counted on either side and would not compare.
+    Ray* rays = (Ray*)MemAlloc(BENCH_RAYS*sizeof(Ray));
+    float worldBlocks = (float)(world.size*CHUNK_SIZE);
+    srand(1);
+    for (int i = 0; i < BENCH_RAYS; i++)
+    {
+        Vector3 position = { worldBlocks*rand()/RAND_MAX, WORLD_HEIGHT - 8.0f, worldBlocks*rand()/RAND_MAX };
+        Vector3 target = { worldBlocks*rand()/RAND_MAX, 0.0f, worldBlocks*rand()/RAND_MAX };
+        rays[i] = (Ray){ position, Vector3Normalize(Vector3Subtract(target, position)) };
+    }
+
+    int hitCount = 0;
+    double startTime = GetBenchTime();
+    for (int i = 0; i < BENCH_RAYS; i++) hitCount += RaycastBlocks(rays[i], BENCH_RAY_DISTANCE, GetBenchBlock).hit;
+    double raycastTime = GetBenchTime() - startTime;
+
+    // Same rays against the meshes, keeping the nearest hit, and check both agree
+    int mismatchCount = 0;
+    startTime = GetBenchTime();
+    for (int i = 0; i < BENCH_RAYS; i++)
+    {
+        RayCollision nearest = { 0 };
+        for (int m = 0; m < meshCount; m++)
+        {
+            if (!GetRayCollisionBox(rays[i], boxes[m]).hit) continue;
+
+            RayCollision collision = GetRayCollisionMesh(rays[i], meshes[m], MatrixIdentity());
+            if (collision.hit && (!nearest.hit || collision.distance < nearest.distance)) nearest = collision;
+        }
+
+        BlockRayHit hit = RaycastBlocks(rays[i], BENCH_RAY_DISTANCE, GetBenchBlock);
+        if ((hit.hit != nearest.hit) || (hit.hit && fabsf(hit.distance - nearest.distance) > 0.01f)) mismatchCount++;
+    }
+    double meshTime = GetBenchTime() - startTime - raycastTime;   // Minus the checking raycasts
+
+    fprintf(output, "rays,hits,meshes,triangles,dda_ms,dda_rays_per_sec,mesh_ms,mesh_rays_per_sec,speedup,mismatches\n");
+    fprintf(output, "%i,%i,%i,%lld,%.3f,%.1f,%.3f,%.1f,%.1f,%i\n", BENCH_RAYS, hitCount, meshCount, triangleCount,
+        raycastTime*1000.0, (raycastTime > 0.0)? BENCH_RAYS/raycastTime : 0.0,
+        meshTime*1000.0, (meshTime > 0.0)? BENCH_RAYS/meshTime : 0.0,
+        (raycastTime > 0.0)? meshTime/raycastTime : 0.0, mismatchCount);
+
+    for (int m = 0; m < meshCount; m++)
+    {
+        MemFree(meshes[m].vertices);
+        MemFree(meshes[m].indices);
+    }
+    MemFree(meshes);
+    MemFree(boxes);
+    MemFree(rays);
+    for (int i = 0; i < sectionCount; i++) FreeBlockStorage(&world.sections[i]);
+    MemFree(world.sections);
+    raycastWorld = NULL;
+}
+
+static int CompareDoubles(const void* a, const void* b)
+{
+    double difference = *(const double*)a - *(const double*)b;
+    return (difference > 0.0) - (difference < 0.0);
+}
+
+// Value at percentile (0..100) of a sorted array
+static double GetPercentile(const double* sorted, int count, double percentile)
+{
+    if (count == 0) return 0.0;
+    int index = (int)(percentile/100.0*(count - 1) + 0.5);
+    return sorted[index];
+}
+
+int main(int argc, char* argv[])
+{
+    FILE* output = stdout;
+    if (argc > 1)
+    {
+        output = fopen(argv[1], "w");
+        if (output == NULL)
+        {
+            fprintf(stderr, "BENCH: Failed to open %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    InitBlockTypes();
+    fprintf(output, "distribution,world_columns,mode,chunks,meshed_chunks,gen_ms,gen_chunks_per_sec,mesh_ms,mesh_chunks_per_sec,verts_per_chunk,mesh_p50_us,mesh_p90_us,mesh_p99_us,mesh_max_us,block_bytes,mesh_bytes,scratch_bytes\n");
+
+    for (int distribution = 0; distribution < BenchDistributionCount; distribution++)
+    {
+        for (int s = 0; s < (int)(sizeof(benchWorldSizes)/sizeof(benchWorldSizes[0])); s++)
+        {
+            BenchWorld world = { 0 };
+            world.size = benchWorldSizes[s];
+            int sectionCount = world.size*world.size*CHUNK_SECTIONS;
+            world.sections = (BlockStorage*)MemAlloc(sectionCount*sizeof(BlockStorage));
+
+            double generateTime = GenerateBenchWorld(&world, distribution);
+
+            int blockBytes = 0;
+            for (int i = 0; i < sectionCount; i++) blockBytes += GetBlockStorageSize(&world.sections[i]);
+
+            double* samples = (double*)MemAlloc(sectionCount*BENCH_ROUNDS*sizeof(double));
+            unsigned char padded[PADDED_CHUNK_VOLUME];
+            unsigned char light[PADDED_CHUNK_VOLUME];   // Open sky everywhere, occlusion is still computed
+            memset(light, FULL_SKY_LIGHT, sizeof(light));
+
+            for (int mode = MeshingNaive; mode <= MeshingGreedy; mode++)
+            {
+                int sampleCount = 0;
+                int meshedCount = 0;
+                long long vertexCount = 0;
+                long long meshBytes = 0;
+                double meshTime = 0.0;
+
+                for (int round = 0; round < BENCH_ROUNDS; round++)
+                {
+                    for (int x = 0; x < world.size; x++)
+                    {
+                        for (int z = 0; z < world.size; z++)
+                        {
+                            for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++)
+                            {
+                                double startTime = GetBenchTime();
+
+                                // Same steps as UpdateChunkJobs() and ChunkMeshJob() in the game
+                                BlockStorage* blocks = GetBenchSection(&world, x, sectionY, z);
+                                if ((blocks->mode == BlockStorageSingle) && (blocks->singleType == Air)) continue;
+
+                                const BlockStorage* neighbours[6];
+                                for (int f = 0; f < 6; f++)
+                                {
+                                    const FaceDirection* face = &faceDirections[f];
+                                    if (sectionY + face->dy < 0) neighbours[f] = &benchFloorBlocks;
+                                    else neighbours[f] = GetBenchSection(&world, x + face->dx, sectionY + face->dy, z + face->dz);
+                                }
+                                if (IsChunkSectionBuried(blocks, neighbours)) continue;
+
+                                ChunkMeshBuilder builder = { 0 };
+                                PadChunkSection(blocks, neighbours, 0, padded);
+                                BuildChunkMesh(padded, light, mode, &builder);
+
+                                double elapsed = GetBenchTime() - startTime;
+                                samples[sampleCount++] = elapsed;
+                                meshTime += elapsed;
+
+                                if (round == 0)
+                                {
+                                    meshedCount++;
+                                    vertexCount += builder.vertexCount;
+                                    meshBytes += (long long)builder.vertexCount*sizeof(ChunkVertex);
+                                }
+                                if (builder.vertices != NULL) MemFree(builder.vertices);
+                            }
+                        }
+                    }
+                }
+
+                qsort(samples, sampleCount, sizeof(double), CompareDoubles);
+
+                int meshedTotal = meshedCount*BENCH_ROUNDS;
+                fprintf(output, "%s,%i,%s,%i,%i,%.3f,%.1f,%.3f,%.1f,%.1f,%.2f,%.2f,%.2f,%.2f,%i,%lld,%i\n",
+                    benchDistributionNames[distribution], world.size, (mode == MeshingGreedy)? "greedy" : "naive",
+                    sectionCount, meshedCount,
+                    generateTime*1000.0, (generateTime > 0.0)? sectionCount/generateTime : 0.0,
+                    meshTime/BENCH_ROUNDS*1000.0, (meshTime > 0.0)? meshedTotal/meshTime : 0.0,
+                    (meshedCount > 0)? (double)vertexCount/meshedCount : 0.0,
+                    GetPercentile(samples, sampleCount, 50.0)*1e6, GetPercentile(samples, sampleCount, 90.0)*1e6,
+                    GetPercentile(samples, sampleCount, 99.0)*1e6, (sampleCount > 0)? samples[sampleCount - 1]*1e6 : 0.0,
+                    blockBytes, meshBytes, jobScratch[0].size);
+                fflush(output);
+            }
+
+            MemFree(samples);
+            for (int i = 0; i < sectionCount; i++) FreeBlockStorage(&world.sections[i]);
+            MemFree(world.sections);
+        }
+    }
+
+    // Picking comparison, in its own file or after the meshing table
+    FILE* raycastOutput = output;
+    if (argc > 2) raycastOutput = fopen(argv[2], "w");
+    if (raycastOutput == NULL) fprintf(stderr, "BENCH: Failed to open %s\n", argv[2]);
+    else
+    {
+        if (raycastOutput == output) fprintf(output, "\n");
+        RunRaycastBench(raycastOutput);
+        if (raycastOutput != output) fclose(raycastOutput);
+    }
+
+    ShutdownJobSystem();    // Frees the mesher's scratch buffer
+    if (output != stdout) fclose(output);
+
+    return 0;
+}
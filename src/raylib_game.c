@@ -12,8 +12,18 @@
 ********************************************************************************************/
 
 #include "raylib.h"
+#include "rlgl.h"
 #include "LizardFreeCamera.h"
 #include "LizardBlockWorld.h"
+#include "LizardJobs.h"
+#include "LizardTerrain.h"
+#include "LizardChunkMesh.h"
+#include "LizardBlockRaycast.h"
+#include "LizardLight.h"
+#include "LizardRegionFile.h"
+#include "LizardRenderScale.h"
+#include "LizardBenchmark.h"
+#include "LizardProfiler.h"
 
 #if defined(PLATFORM_WEB)
     #define CUSTOM_MODAL_DIALOGS            // Force custom modal dialogs usage
@@ -23,419 +33,1690 @@
 #include <stdio.h>                          // Required for: printf()
 #include <stdlib.h>                         // Required for: 
 #include <string.h>                         // Required for: 
+#include <float.h>                          // Required for: FLT_MAX
 
+#if defined(PLATFORM_DESKTOP)
+    #define GLSL_VERSION            330
+#else   // PLATFORM_ANDROID, PLATFORM_WEB
+    #define GLSL_VERSION            100
+#endif
 
 static const int screenWidth = 800;
 static const int screenHeight = 450;
 static RenderTexture2D target = { 0 };
 
 Texture2D LOGO;
-Texture2D BLOCKS;
+Texture2D BLOCKS; // Block atlas, see LoadBlockAtlas()
 
 
-Shader pixelatedShader;
+Shader pixelatedShader; // Stretches the scaled scene render over the screen (pixel.fs)
+int pixelRenderSizeLoc = -1;
+int pixelFilterLoc = -1;
+Shader chunkShader; // Decodes packed chunk vertices and wraps texcoords inside their atlas tile (lizard.vs/lizard.fs)
+int chunkTileLoc = -1; // Location of the vertexTile attribute in chunkShader
 
 #pragma region MINECRAFT
 bool ProceduralBlocks;
-//Chunk definitions
-#define CHUNK_SIZE 16  // Chunk size: 16x16x16 blocks
-#define BLOCK_SIZE 1.0f // Each block is 1x1x1 units
-#define WORLD_WIDTH 4  // 4x4 chunks in total
-#define WORLD_DEPTH 4
-// Texture atlas definitions
-#define ATLAS_WIDTH 2 // Number of textures in a row
-#define ATLAS_HEIGHT 2 // Number of textures in a column
-#define BLOCK_TEXTURE_SIZE 0.5f // Size of each block texture (1 / 4 for 4x2 atlas)
-// Block types
-enum BlockType
-{
-    Air,
-    Dirt,
-    Grass,
-    Stone,
-    Sand,
-    Water,
-    BlockTypeCount // Use this to keep track of the number of block types
-};
-typedef struct
-{
-    int type;  // 0 = air, 1 = solid block
-} Block;
+// Chunk cache definitions
+#define CHUNK_CACHE_SIZE 512 // Maximum number of resident chunks, bounds world memory
+#define CHUNK_HASH_SIZE 1024 // Buckets for chunk coordinate lookups (power of two)
+#define MAX_CHUNK_LOADS_PER_FRAME 4 // Chunks generated per frame while streaming
+#define CHUNK_AUTOSAVE_INTERVAL (REGION_SYNC_INTERVAL - 0.5) // Seconds between autosaves of resident chunks, ends just before a web sync
+// Chunk meshes are drawn with 16 bit indices from one shared quad index buffer
+#define MAX_CHUNK_DRAW_QUADS 16384 // Quads per draw call, 4 vertices each fill the 16 bit index range
+// Chunk meshes are sub-allocated from shared vertex pages, each page belongs to one region of chunk columns and
+// its vertex positions are relative to the region, so all of a page's sections are drawn with one matrix
+#define CHUNK_REGION_SIZE 8 // Chunk columns per region side, 8 * CHUNK_SIZE blocks still fit the byte vertex positions
+#define CHUNK_PAGE_VERTICES 65536 // Vertices per shared page, bigger meshes get a page of their own
+#define MAX_CHUNK_PAGES 128
+#define MAX_PAGE_FREE_RANGES (CHUNK_REGION_SIZE * CHUNK_REGION_SIZE * CHUNK_SECTIONS + 1) // Enough for every section of a region
+int meshingMode = MeshingGreedy; // Chunk meshing mode, switched at runtime with G
+// Range of a shared vertex page holding a chunk mesh, drawn with the shared chunkIndexBuffer
+typedef struct {
+    int page; // Slot in chunkPages
+    int firstVertex;
+    int vertexCount; // 0 for no mesh
+} ChunkMesh;
+// Shared vertex buffer the meshes of one region are sub-allocated from
+typedef struct {
+    unsigned int vaoId;
+    unsigned int vboId; // ChunkVertex buffer
+    bool loaded;
+    int regionX, regionZ; // Region of the meshes, in CHUNK_REGION_SIZE chunks
+    int capacity; // In vertices
+    int usedVertices;
+    int freeRangeCount;
+    int freeFirst[MAX_PAGE_FREE_RANGES]; // Free vertex ranges, sorted by first vertex
+    int freeCount[MAX_PAGE_FREE_RANGES];
+} ChunkPage;
+ChunkPage chunkPages[MAX_CHUNK_PAGES];
+int chunkPageCount = 0; // Loaded pages
+// Chunk GPU memory is held to a budget by dropping the meshes of the farthest columns, see EnforceChunkVramBudget()
+size_t chunkVramBytes = 0; // Vertex pages and the shared index buffer, in bytes
+size_t chunkVramUsedBytes = 0; // Page ranges holding meshes and the shared index buffer, what the budget limits
+size_t chunkVramBudget = 48 * 1024 * 1024; // Set with --vram-budget, in bytes
+float chunkMeshDistance = FLT_MAX; // Columns this far from the camera or farther, in chunks, are not meshed
+int chunkMeshCenterX = 0, chunkMeshCenterZ = 0; // Camera chunk when chunkMeshDistance last changed
+Vector3 chunkMeshPosition = { 0 }; // Camera position of the last UpdateChunkJobs()
+int chunkMeshReuseCount = 0; // Section meshes uploaded this frame over their old range
+// One CHUNK_SIZE cube of a chunk column, meshed and drawn on its own
 typedef struct {
-    Block blocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE]; // 3D array of blocks in the chunk
+    BlockStorage blocks; // Block types of the section, palette compressed (see LizardBlockWorld.h)
+    BoundingBox boundingBox; // The section's bounding box
+    ChunkMesh mesh; // Mesh for the section, empty for all-air and buried sections
+    bool meshNeedsUpdate; // Whether we need to rebuild the section's mesh
+    bool meshDropped; // Whether the mesh was dropped for the VRAM budget, rebuilt once within chunkMeshDistance again
+    bool jobPending; // Whether a mesh job is building this section
+    int chunkIndex; // Slot of the owning column in chunkCache
+    int sectionY; // Height of the section in the column, in sections
+    int meshMode; // MeshingMode of the mesh job, fixed when it is scheduled
+    unsigned char* meshBlocks; // Padded copy of the blocks and neighbour borders read by the mesh job
+    unsigned char* meshLight; // Padded light read by the mesh job, after the blocks in the same allocation, NULL for lower levels of detail
+    ChunkMeshBuilder meshData; // Mesh built by a worker, waiting for upload
+    unsigned char faceConnections[6]; // Faces joined through air, see GetBlockStorageConnections()
+    unsigned int visibleFrame; // Last occlusion pass that reached this section
+    bool edited; // Whether the section is in editedSections
+    bool connectionsNeedUpdate; // Whether blocks changed since faceConnections was computed
+    unsigned char* light; // Sky light << 4 | block light per BLOCK_INDEX (see LizardLight.h), NULL while every block has lightFill
+    unsigned char lightFill;
+} ChunkSection;
+// Chunk column of CHUNK_SECTIONS stacked sections, the unit of streaming and terrain generation
+typedef struct {
+    ChunkSection sections[CHUNK_SECTIONS]; // Bottom to top
     Vector3 position; // World position of this chunk
-    BoundingBox boundingBox; // The chunk's bounding box
-    Mesh mesh; // Mesh for the chunk
-    Model model;
     Color chunkColor;
-    bool meshNeedsUpdate; // Whether we need to rebuild the chunk's mesh
+    int lod; // Level of detail the sections are meshed at, cells of 1 << lod blocks
+    bool loaded; // Whether this cache slot holds a chunk
+    int chunkX, chunkZ; // Chunk coordinate, in chunks
+    int hashNext; // Next chunk in the same hash bucket, -1 if none
+    int lruPrev, lruNext; // Neighbours in the LRU list, -1 if none
+    unsigned int lastUsedFrame; // Last cache update that needed this chunk
+    bool terrainReady; // Whether the blocks have been generated
+    bool needsSave; // Whether the blocks differ from the region file (newly generated or edited)
+    unsigned char* savedData; // Column read from its region file for the terrain job to decode, NULL to generate
+    int savedSize;
+    int pendingJobs; // Worker jobs using this chunk, it must not be evicted while any is running
 } Chunk;
-Chunk worldChunks[WORLD_WIDTH][WORLD_DEPTH];
-
-// Scale factors
-float scale = CHUNK_SIZE; // Adjust scale for the noise
-float heightScale = 16; // Maximum height for your terrain
-// Define the center of the world
-int worldCenterX = (WORLD_WIDTH * CHUNK_SIZE) / 2;
-int worldCenterZ = (WORLD_DEPTH * CHUNK_SIZE) / 2;
-Image perlinImage;
-Texture2D perlinTexture;
-// Get height using Perlin noise with island falloff
-float GetHeight(int x, int z) {
-    Color HeightColor = GetImageColor(perlinImage, x, z);
-    float heightValue = (float)HeightColor.r / 255.0f;
-    return heightValue * heightScale;
+// Streaming chunk cache: a fixed pool of chunks keyed by chunk coordinate, evicted least recently used first
+Chunk chunkCache[CHUNK_CACHE_SIZE];
+int chunkHashBuckets[CHUNK_HASH_SIZE];
+int freeChunkSlots[CHUNK_CACHE_SIZE];
+int freeChunkSlotCount = 0;
+int chunkLruHead = -1; // Most recently used chunk
+int chunkLruTail = -1; // Least recently used chunk, evicted first
+int residentChunkCount = 0;
+unsigned int chunkCacheFrame = 0;
+int chunkLoadRadius = 12; // Chunks kept loaded around the camera, must fit in CHUNK_CACHE_SIZE
+float chunkLodDistances[MAX_CHUNK_LOD] = { 4.0f, 7.0f, 10.0f }; // Distance to the camera, in chunks, where each coarser level starts
+double chunkUploadBudget = 0.004; // Seconds per frame spent uploading finished chunk meshes
+double chunkLoadBudget = 0.004; // Seconds per frame spent loading chunks, counts when terrain is generated on the main thread
+double chunkSaveBudget = 0.002; // Seconds per frame spent autosaving changed resident chunks
+double chunkAutosaveTime = 0.0; // Start of the last autosave pass
+int chunkAutosaveSlot = -1; // Next cache slot the running autosave pass looks at, -1 between passes
+double chunkMeshBudget = 0.004; // Seconds per frame spent preparing mesh jobs, counts when meshes are built on the main thread
+int drawnVertexCount = 0; // Chunk vertices drawn last frame, used to compare meshing modes
+int drawnSectionCount = 0; // Sections with a mesh drawn last frame
+int chunkDrawCallCount = 0; // Draw calls issued for chunks last frame
+int chunkRemeshCount = 0; // Section meshes uploaded this frame
+int chunkLoadCount = 0; // Chunks loaded by the last UpdateChunkCache()
+int culledChunkCount = 0; // Sections with a mesh skipped by frustum culling last frame
+int occludedSectionCount = 0; // Sections with a mesh inside the frustum skipped by occlusion culling last frame
+bool occlusionCulling = true; // Skip sections the camera cannot see through air, toggled with O
+unsigned int occlusionFrame = 0; // Current occlusion pass, sections it reaches get this visibleFrame
+// Sections changed by block edits since the last frame, remeshed on the main thread so edits show up right away
+#define MAX_EDITED_SECTIONS 256
+ChunkSection* editedSections[MAX_EDITED_SECTIONS];
+int editedSectionCount = 0;
+FlythroughPath recordedPath = { 0 }; // Camera path recorded with F6
+bool flythroughRecording = false;
+double flythroughRecordStart = 0.0;
+double editRemeshBudget = 0.002; // Seconds per frame spent remeshing edited sections, the rest go to the workers
+double lightBudget = 0.002; // Seconds per frame spent spreading light, edits and the seams of arriving columns
+bool lightEditRemesh = false; // Whether light changes are remeshed right away like edits, otherwise by the mesh jobs
+#define BLOCK_PICK_DISTANCE 64.0f // Reach of the block picking ray, in blocks
+int cameraMode = EditMode; // EditMode flies freely, FPSMode is stopped by blocks (switched with C)
+BlockRayHit pickedBlock = { 0 }; // Block under the mouse, or under the screen center in FPSMode
+static const BoundingBox playerBox = { { -0.3f, -1.6f, -0.3f }, { 0.3f, 0.2f, 0.3f } }; // Collision box around the camera in FPSMode
+unsigned int chunkIndexBuffer = 0; // Quad indices 0-1-2-0-2-3 for MAX_CHUNK_DRAW_QUADS quads, shared by every chunk mesh
+// View frustum as six planes (a, b, c, d) with normals pointing inwards: left, right, bottom, top, near, far
+typedef struct {
+    Vector4 planes[6];
+} Frustum;
+
+// Extract the frustum planes from a combined view-projection matrix (Gribb/Hartmann)
+Frustum GetFrustum(Matrix viewProjection)
+{
+    Matrix m = viewProjection;
+    Vector4 row0 = { m.m0, m.m4, m.m8, m.m12 };
+    Vector4 row1 = { m.m1, m.m5, m.m9, m.m13 };
+    Vector4 row2 = { m.m2, m.m6, m.m10, m.m14 };
+    Vector4 row3 = { m.m3, m.m7, m.m11, m.m15 };
+
+    Frustum frustum = { 0 };
+    frustum.planes[0] = (Vector4){ row3.x + row0.x, row3.y + row0.y, row3.z + row0.z, row3.w + row0.w }; // Left
+    frustum.planes[1] = (Vector4){ row3.x - row0.x, row3.y - row0.y, row3.z - row0.z, row3.w - row0.w }; // Right
+    frustum.planes[2] = (Vector4){ row3.x + row1.x, row3.y + row1.y, row3.z + row1.z, row3.w + row1.w }; // Bottom
+    frustum.planes[3] = (Vector4){ row3.x - row1.x, row3.y - row1.y, row3.z - row1.z, row3.w - row1.w }; // Top
+    frustum.planes[4] = (Vector4){ row3.x + row2.x, row3.y + row2.y, row3.z + row2.z, row3.w + row2.w }; // Near
+    frustum.planes[5] = (Vector4){ row3.x - row2.x, row3.y - row2.y, row3.z - row2.z, row3.w - row2.w }; // Far
+
+    // Normalize so plane distances are in world units
+    for (int i = 0; i < 6; i++) {
+        Vector4 plane = frustum.planes[i];
+        float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0.0f) frustum.planes[i] = (Vector4){ plane.x / length, plane.y / length, plane.z / length, plane.w / length };
+    }
+
+    return frustum;
 }
 // Function to check if a chunk is inside the camera's frustum
-bool IsChunkVisible(Camera3D camera, BoundingBox box)
+bool IsChunkVisible(const Frustum* frustum, BoundingBox box)
 {
+    for (int i = 0; i < 6; i++) {
+        Vector4 plane = frustum->planes[i];
+
+        // Test the box corner furthest along the plane normal, if it is behind the plane the whole box is
+        Vector3 corner = {
+            (plane.x >= 0.0f) ? box.max.x : box.min.x,
+            (plane.y >= 0.0f) ? box.max.y : box.min.y,
+            (plane.z >= 0.0f) ? box.max.z : box.min.z
+        };
+        if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f) return false;
+    }
     return true;
 }
-// Helper function to check if a block at (x, y, z) is solid
+// Helper function to check if a block at (x, y, z) is solid, y is the height in the whole column
 bool IsBlockSolid(Chunk* chunk, int x, int y, int z) {
     // If the block is out of bounds, return false (air)
-    if (x < 0 || x >= CHUNK_SIZE || y < 0 || y >= CHUNK_SIZE || z < 0 || z >= CHUNK_SIZE) return false;
-    return chunk->blocks[x][y][z].type != Air;
+    if (x < 0 || x >= CHUNK_SIZE || y < 0 || y >= WORLD_HEIGHT || z < 0 || z >= CHUNK_SIZE) return false;
+    return blockTypes[GetBlockType(&chunk->sections[y / CHUNK_SIZE].blocks, x, y % CHUNK_SIZE, z)].solid;
+}
+// Describe the ChunkVertex layout for the currently bound vertex buffer, starting at firstVertex
+void SetChunkVertexAttributes(int firstVertex) {
+    int offset = firstVertex * (int)sizeof(ChunkVertex);
+
+    // Position and face as 4 unsigned bytes, read as plain integers (not normalized) by the shader
+    rlSetVertexAttribute(chunkShader.locs[SHADER_LOC_VERTEX_POSITION], 4, RL_UNSIGNED_BYTE, false, sizeof(ChunkVertex), (void*)(size_t)offset);
+    rlEnableVertexAttribute(chunkShader.locs[SHADER_LOC_VERTEX_POSITION]);
+    // Atlas cell column and row, corner light and ambient occlusion
+    rlSetVertexAttribute(chunkTileLoc, 4, RL_UNSIGNED_BYTE, false, sizeof(ChunkVertex), (void*)(size_t)(offset + 4));
+    rlEnableVertexAttribute(chunkTileLoc);
+}
+// Function to build the shared quad index buffer, GL thread only. Call before loading any chunk mesh.
+void LoadChunkIndexBuffer(void) {
+    const int indexCount = MAX_CHUNK_DRAW_QUADS * 6;
+    unsigned short* indices = (unsigned short*)MemAlloc(indexCount * sizeof(unsigned short));
+
+    for (int quad = 0; quad < MAX_CHUNK_DRAW_QUADS; quad++) {
+        unsigned short first = (unsigned short)(quad * 4);
+        unsigned short* quadIndices = &indices[quad * 6];
+        quadIndices[0] = first + 0;
+        quadIndices[1] = first + 1;
+        quadIndices[2] = first + 2;
+        quadIndices[3] = first + 0;
+        quadIndices[4] = first + 2;
+        quadIndices[5] = first + 3;
+    }
+
+    // Make sure no vertex array captures the binding
+    rlDisableVertexArray();
+    chunkIndexBuffer = rlLoadVertexBufferElement(indices, indexCount * sizeof(unsigned short), false);
+    chunkVramBytes += indexCount * sizeof(unsigned short);
+    chunkVramUsedBytes += indexCount * sizeof(unsigned short);
+    MemFree(indices);
+}
+void UnloadChunkIndexBuffer(void) {
+    rlUnloadVertexBuffer(chunkIndexBuffer);
+    chunkVramBytes -= MAX_CHUNK_DRAW_QUADS * 6 * sizeof(unsigned short);
+    chunkVramUsedBytes -= MAX_CHUNK_DRAW_QUADS * 6 * sizeof(unsigned short);
+    chunkIndexBuffer = 0;
+}
+// Function to build the block atlas from an image of BLOCK_TILE_SIZE tiles, GL thread only. Every entry of blockTextures
+// gets a cell (see BLOCK_ATLAS_CELL_SIZE) with its tinted tile. Cells and rows come in powers of two, so mipmaps
+// average whole cells and never mix two textures. tileSize gets the size of a tile in texture coordinates.
+Texture2D LoadBlockAtlas(const char* fileName, Vector2* tileSize) {
+    Image tiles = LoadImage(fileName);
+    ImageFormat(&tiles, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    int tileColumns = tiles.width / BLOCK_TILE_SIZE;
+    int tileCount = tileColumns * (tiles.height / BLOCK_TILE_SIZE);
+
+    int rows = 1;
+    while (rows * BLOCK_ATLAS_COLUMNS < blockTextureCount) rows *= 2;
+    Image atlas = GenImageColor(BLOCK_ATLAS_COLUMNS * BLOCK_ATLAS_CELL_SIZE, rows * BLOCK_ATLAS_CELL_SIZE, BLANK);
+
+    // The tile is drawn in 3x3 pieces, wrapping around into the border. Per axis: offset in the cell, offset in the tile, size
+    const int half = BLOCK_TILE_SIZE / 2;
+    const int pieces[3][3] = { { 0, half, half }, { half, 0, BLOCK_TILE_SIZE }, { half + BLOCK_TILE_SIZE, 0, half } };
+
+    for (int i = 0; i < blockTextureCount; i++) {
+        BlockTexture texture = blockTextures[i];
+        if (texture.tile < 0 || texture.tile >= tileCount) {
+            TraceLog(LOG_WARNING, "BLOCKS: [%s] Tile %i does not exist", fileName, texture.tile);
+            continue;
+        }
+
+        int tileX = (texture.tile % tileColumns) * BLOCK_TILE_SIZE;
+        int tileY = (texture.tile / tileColumns) * BLOCK_TILE_SIZE;
+        int cellX = (i % BLOCK_ATLAS_COLUMNS) * BLOCK_ATLAS_CELL_SIZE;
+        int cellY = (i / BLOCK_ATLAS_COLUMNS) * BLOCK_ATLAS_CELL_SIZE;
+
+        for (int v = 0; v < 3; v++) {
+            for (int u = 0; u < 3; u++) {
+                Rectangle source = { (float)(tileX + pieces[u][1]), (float)(tileY + pieces[v][1]), (float)pieces[u][2], (float)pieces[v][2] };
+                Rectangle dest = { (float)(cellX + pieces[u][0]), (float)(cellY + pieces[v][0]), (float)pieces[u][2], (float)pieces[v][2] };
+                ImageDraw(&atlas, tiles, source, dest, texture.tint);
+            }
+        }
+    }
+
+    Texture2D texture = LoadTextureFromImage(atlas);
+    GenTextureMipmaps(&texture);
+    // Sharp texels up close, trilinear filtering in the distance so faces do not shimmer
+    rlTextureParameters(texture.id, RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_NEAREST);
+    rlTextureParameters(texture.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_MIP_LINEAR);
+    *tileSize = (Vector2){ (float)BLOCK_TILE_SIZE / atlas.width, (float)BLOCK_TILE_SIZE / atlas.height };
+
+    UnloadImage(tiles);
+    UnloadImage(atlas);
+    return texture;
+}
+// Region of a chunk coordinate, rounding down for negative coordinates
+int GetChunkRegion(int chunkCoordinate)
+{
+    return (chunkCoordinate >= 0) ? chunkCoordinate / CHUNK_REGION_SIZE : (chunkCoordinate + 1) / CHUNK_REGION_SIZE - 1;
+}
+// Function to create an empty vertex page for a region, GL thread only. Returns its slot or -1 if every slot is in use.
+int LoadChunkPage(int regionX, int regionZ, int capacity)
+{
+    int index = 0;
+    while (index < MAX_CHUNK_PAGES && chunkPages[index].loaded) index++;
+    if (index == MAX_CHUNK_PAGES) return -1;
+
+    ChunkPage* page = &chunkPages[index];
+    page->loaded = true;
+    page->regionX = regionX;
+    page->regionZ = regionZ;
+    page->capacity = capacity;
+    page->usedVertices = 0;
+    page->freeRangeCount = 1;
+    page->freeFirst[0] = 0;
+    page->freeCount[0] = capacity;
+
+    page->vaoId = rlLoadVertexArray();
+    rlEnableVertexArray(page->vaoId);
+    page->vboId = rlLoadVertexBuffer(NULL, capacity * sizeof(ChunkVertex), true);
+    SetChunkVertexAttributes(0);
+    rlEnableVertexBufferElement(chunkIndexBuffer);
+    rlDisableVertexArray();
+
+    chunkPageCount++;
+    chunkVramBytes += capacity * sizeof(ChunkVertex);
+    return index;
+}
+void UnloadChunkPage(int index)
+{
+    ChunkPage* page = &chunkPages[index];
+    rlUnloadVertexArray(page->vaoId);
+    rlUnloadVertexBuffer(page->vboId);
+    page->loaded = false;
+    chunkPageCount--;
+    chunkVramBytes -= page->capacity * sizeof(ChunkVertex);
 }
-// Function to get texture coordinates
-Vector2 GetTextureCoord(int blockType)
+// Drop a free range of a page that has been used up
+void RemoveChunkPageFreeRange(ChunkPage* page, int i)
 {
-    int x = blockType % ATLAS_WIDTH;
-    int y = blockType / ATLAS_WIDTH;
-    return (Vector2) { x* BLOCK_TEXTURE_SIZE, y* BLOCK_TEXTURE_SIZE };
+    page->freeRangeCount--;
+    memmove(&page->freeFirst[i], &page->freeFirst[i + 1], (page->freeRangeCount - i) * sizeof(int));
+    memmove(&page->freeCount[i], &page->freeCount[i + 1], (page->freeRangeCount - i) * sizeof(int));
 }
-//Function to generate the blocks mesh.
-Mesh GenMeshCustom(Vector3* vertices, Vector2* texcoords, unsigned int* indices, int vertexCount, int indexCount) {
-    Mesh mesh = { 0 };
+// Take the first free range of a page that fits vertexCount vertices, returns its first vertex or -1 if none fits
+int AllocateChunkPageRange(ChunkPage* page, int vertexCount)
+{
+    for (int i = 0; i < page->freeRangeCount; i++) {
+        if (page->freeCount[i] < vertexCount) continue;
 
-    // Allocate space for vertices, texcoords, and indices
-    mesh.vertexCount = vertexCount;
-    mesh.triangleCount = indexCount / 3;
+        int first = page->freeFirst[i];
+        page->freeFirst[i] += vertexCount;
+        page->freeCount[i] -= vertexCount;
+
+        if (page->freeCount[i] == 0) RemoveChunkPageFreeRange(page, i);
+        page->usedVertices += vertexCount;
+        chunkVramUsedBytes += vertexCount * sizeof(ChunkVertex);
+        return first;
+    }
+    return -1;
+}
+// Extend a used range by extraCount vertices into the free range right after it, returns false if that is too small
+bool GrowChunkPageRange(ChunkPage* page, int first, int vertexCount, int extraCount)
+{
+    int end = first + vertexCount;
+    int i = 0;
+    while (i < page->freeRangeCount && page->freeFirst[i] < end) i++;
+    if (i == page->freeRangeCount || page->freeFirst[i] != end || page->freeCount[i] < extraCount) return false;
+
+    page->freeFirst[i] += extraCount;
+    page->freeCount[i] -= extraCount;
+    if (page->freeCount[i] == 0) RemoveChunkPageFreeRange(page, i);
+    page->usedVertices += extraCount;
+    chunkVramUsedBytes += extraCount * sizeof(ChunkVertex);
+    return true;
+}
+// Return a range to a page, merging it with the free ranges around it
+void FreeChunkPageRange(ChunkPage* page, int first, int vertexCount)
+{
+    int i = 0;
+    while (i < page->freeRangeCount && page->freeFirst[i] < first) i++;
 
-    mesh.vertices = (float*)MemAlloc(vertexCount * 3 * sizeof(float));   // 3 components (x, y, z)
-    mesh.texcoords = (float*)MemAlloc(vertexCount * 2 * sizeof(float));  // 2 components (u, v)
-    mesh.indices = (unsigned short*)MemAlloc(indexCount * sizeof(unsigned short));
+    bool joinsPrevious = (i > 0 && page->freeFirst[i - 1] + page->freeCount[i - 1] == first);
+    bool joinsNext = (i < page->freeRangeCount && first + vertexCount == page->freeFirst[i]);
 
-    // Copy vertex data
-    for (int i = 0; i < vertexCount; i++) {
-        mesh.vertices[i * 3 + 0] = vertices[i].x;
-        mesh.vertices[i * 3 + 1] = vertices[i].y;
-        mesh.vertices[i * 3 + 2] = vertices[i].z;
-        mesh.texcoords[i * 2 + 0] = texcoords[i].x;
-        mesh.texcoords[i * 2 + 1] = texcoords[i].y;
+    if (joinsPrevious && joinsNext) {
+        page->freeCount[i - 1] += vertexCount + page->freeCount[i];
+        RemoveChunkPageFreeRange(page, i);
+    }
+    else if (joinsPrevious) page->freeCount[i - 1] += vertexCount;
+    else if (joinsNext) {
+        page->freeFirst[i] = first;
+        page->freeCount[i] += vertexCount;
+    }
+    else {
+        memmove(&page->freeFirst[i + 1], &page->freeFirst[i], (page->freeRangeCount - i) * sizeof(int));
+        memmove(&page->freeCount[i + 1], &page->freeCount[i], (page->freeRangeCount - i) * sizeof(int));
+        page->freeFirst[i] = first;
+        page->freeCount[i] = vertexCount;
+        page->freeRangeCount++;
+    }
+    page->usedVertices -= vertexCount;
+    chunkVramUsedBytes -= vertexCount * sizeof(ChunkVertex);
+}
+// Function to copy a chunk mesh into a page of its region, GL thread only. Vertices must be relative to the region.
+ChunkMesh LoadChunkMesh(const ChunkVertex* vertices, int vertexCount, int regionX, int regionZ) {
+    ChunkMesh mesh = { 0 };
+    if (vertexCount == 0) return mesh;
+
+    int first = -1;
+    int index = 0;
+    for (; index < MAX_CHUNK_PAGES; index++) {
+        ChunkPage* page = &chunkPages[index];
+        if (!page->loaded || page->regionX != regionX || page->regionZ != regionZ) continue;
+        if ((first = AllocateChunkPageRange(page, vertexCount)) >= 0) break;
     }
 
-    // Copy index data
-    for (int i = 0; i < indexCount; i++) {
-        mesh.indices[i] = indices[i];
+    // No room in the region's pages, start a new one
+    if (first < 0) {
+        index = LoadChunkPage(regionX, regionZ, (vertexCount > CHUNK_PAGE_VERTICES) ? vertexCount : CHUNK_PAGE_VERTICES);
+        if (index < 0) {
+            TraceLog(LOG_WARNING, "CHUNK: Out of vertex pages, mesh of %i vertices dropped", vertexCount);
+            return mesh;
+        }
+        first = AllocateChunkPageRange(&chunkPages[index], vertexCount);
     }
 
-    // Upload mesh data to the GPU (for fast rendering)
-    UploadMesh(&mesh, true);
+    rlUpdateVertexBuffer(chunkPages[index].vboId, vertices, vertexCount * sizeof(ChunkVertex), first * sizeof(ChunkVertex));
 
+    mesh.page = index;
+    mesh.firstVertex = first;
+    mesh.vertexCount = vertexCount;
     return mesh;
 }
-//Generate mesh chunk function
-void GenerateChunkMesh(Chunk* chunk) {
+// Bind a page for drawing, rebinding its index buffer by hand where vertex arrays are not supported
+void BindChunkPage(const ChunkPage* page) {
+    if (!rlEnableVertexArray(page->vaoId)) rlEnableVertexBufferElement(chunkIndexBuffer);
 
+    // The attribute pointers are set per draw and read the bound vertex buffer
+    rlEnableVertexBuffer(page->vboId);
+}
+// Draw a range of the bound page with the shared index buffer. Ranges over MAX_CHUNK_DRAW_QUADS quads (65536 vertices)
+// are drawn in several calls, each pointing the attributes at its first vertex so the 16 bit indices stay in range.
+void DrawChunkPageRange(int firstVertex, int vertexCount) {
+    int quadCount = vertexCount / 4;
+
+    for (int firstQuad = 0; firstQuad < quadCount; firstQuad += MAX_CHUNK_DRAW_QUADS) {
+        int quads = quadCount - firstQuad;
+        if (quads > MAX_CHUNK_DRAW_QUADS) quads = MAX_CHUNK_DRAW_QUADS;
+
+        SetChunkVertexAttributes(firstVertex + firstQuad * 4);
+        rlDrawVertexArrayElements(0, quads * 6, 0);
+        chunkDrawCallCount++;
+    }
+}
+// Function to release a chunk mesh's page range, unloading the page once it is empty
+void UnloadChunkMesh(ChunkMesh* mesh) {
+    if (mesh->vertexCount == 0) return;
+
+    ChunkPage* page = &chunkPages[mesh->page];
+    FreeChunkPageRange(page, mesh->firstVertex, mesh->vertexCount);
+    if (page->usedVertices == 0) UnloadChunkPage(mesh->page);
+    *mesh = (ChunkMesh){ 0 };
+}
+// Function to replace a chunk mesh, GL thread only. The vertices are written over the old range when they fit in it
+// or in the free space right after it, so remeshing an edited section neither moves it nor churns pages.
+void UpdateChunkMesh(ChunkMesh* mesh, const ChunkVertex* vertices, int vertexCount, int regionX, int regionZ) {
+    if (mesh->vertexCount > 0 && vertexCount > 0) {
+        ChunkPage* page = &chunkPages[mesh->page];
+        bool fits = (vertexCount <= mesh->vertexCount);
+        if (fits && vertexCount < mesh->vertexCount) FreeChunkPageRange(page, mesh->firstVertex + vertexCount, mesh->vertexCount - vertexCount);
+        else if (!fits) fits = GrowChunkPageRange(page, mesh->firstVertex, mesh->vertexCount, vertexCount - mesh->vertexCount);
+
+        if (fits) {
+            rlUpdateVertexBuffer(page->vboId, vertices, vertexCount * sizeof(ChunkVertex), mesh->firstVertex * sizeof(ChunkVertex));
+            mesh->vertexCount = vertexCount;
+            chunkMeshReuseCount++;
+            return;
+        }
+    }
 
-    if (chunk->mesh.vertexCount > 0) {
-        UnloadMesh(chunk->mesh);
+    UnloadChunkMesh(mesh);
+    *mesh = LoadChunkMesh(vertices, vertexCount, regionX, regionZ);
+}
+// Upload a built mesh and replace the section's mesh with it, GL thread only. Frees the builder arrays.
+void UploadChunkMesh(ChunkSection* section, ChunkMeshBuilder* builder) {
+    Chunk* chunk = &chunkCache[section->chunkIndex];
+    int regionX = GetChunkRegion(chunk->chunkX);
+    int regionZ = GetChunkRegion(chunk->chunkZ);
+
+    PROFILE_BEGIN(ProfileMeshUpload);
+    // Move the section local vertices to their place in the region
+    unsigned char offsetX = (unsigned char)((chunk->chunkX - regionX * CHUNK_REGION_SIZE) * CHUNK_SIZE);
+    unsigned char offsetY = (unsigned char)(section->sectionY * CHUNK_SIZE);
+    unsigned char offsetZ = (unsigned char)((chunk->chunkZ - regionZ * CHUNK_REGION_SIZE) * CHUNK_SIZE);
+    for (int i = 0; i < builder->vertexCount; i++) {
+        builder->vertices[i].x += offsetX;
+        builder->vertices[i].y += offsetY;
+        builder->vertices[i].z += offsetZ;
     }
 
+    UpdateChunkMesh(&section->mesh, builder->vertices, builder->vertexCount, regionX, regionZ);
+    chunkRemeshCount++;
+    PROFILE_END(ProfileMeshUpload);
+
+    // The vertices are in the GPU buffer now
+    if (builder->vertices != NULL) MemFree(builder->vertices);
+    *builder = (ChunkMeshBuilder){ 0 };
+}
+Chunk* GetChunk(int chunkX, int chunkZ);
+// Section reached by the occlusion pass: the face it was entered through and the directions walked to get there
+typedef struct {
+    Chunk* chunk;
+    int sectionY;
+    int entryFace; // faceDirections index, -1 for the camera's section
+    int directions; // Bit per faceDirections index
+} SectionVisit;
+// Function to find the sections visible from a position (cave culling). Starting at the camera's section, walk
+// to neighbouring sections in the frustum, only leaving a section through a face its air connects to the face
+// it was entered by and never turning back towards the camera. Reached sections get visibleFrame = occlusionFrame.
+// Returns false when the camera's chunk is not resident, nothing can be culled then.
+bool UpdateSectionVisibility(Vector3 position, const Frustum* frustum)
+{
+    static SectionVisit queue[CHUNK_CACHE_SIZE * CHUNK_SECTIONS];
+
+    Chunk* start = GetChunk((int)floorf(position.x / (CHUNK_SIZE * BLOCK_SIZE)), (int)floorf(position.z / (CHUNK_SIZE * BLOCK_SIZE)));
+    if (start == NULL) return false;
+
+    int startY = (int)floorf(position.y / (CHUNK_SIZE * BLOCK_SIZE));
+    startY = (startY < 0) ? 0 : (startY >= CHUNK_SECTIONS) ? CHUNK_SECTIONS - 1 : startY;
+
+    occlusionFrame++;
+    int head = 0;
+    int tail = 0;
+    start->sections[startY].visibleFrame = occlusionFrame;
+    queue[tail++] = (SectionVisit){ start, startY, -1, 0 };
 
+    while (head < tail) {
+        SectionVisit visit = queue[head++];
+        ChunkSection* section = &visit.chunk->sections[visit.sectionY];
 
-    // Max number of vertices and indices for all blocks in the chunk (6 faces per block)
-    const int maxVertices = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 6 * 4;
-    const int maxIndices = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 6 * 6;
+        // Chunks still generating have no blocks yet, treat them as open
+        int exits = 0x3f;
+        if (visit.entryFace >= 0 && visit.chunk->terrainReady) exits = section->faceConnections[visit.entryFace];
 
-    Vector3* vertices = (Vector3*)MemAlloc(maxVertices * sizeof(Vector3));
-    Vector2* texcoords = (Vector2*)MemAlloc(maxVertices * sizeof(Vector2));
-    unsigned int* indices = (unsigned int*)MemAlloc(maxIndices * sizeof(unsigned int));
+        for (int f = 0; f < 6; f++) {
+            // Faces come in opposite pairs, f ^ 1 is the way back
+            if (!(exits & (1 << f)) || (visit.directions & (1 << (f ^ 1)))) continue;
 
-    int vertexCount = 0;
-    int indexCount = 0;
-
-    // For each block in the chunk
-    for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int y = 0; y < CHUNK_SIZE; y++) {
-            for (int z = 0; z < CHUNK_SIZE; z++) {
-                Block currentBlock = chunk->blocks[x][y][z];
-
-                if (currentBlock.type != Air) {  // Only process solid blocks
-
-                    Vector3 blockPosition = (Vector3){ x * BLOCK_SIZE, y * BLOCK_SIZE, z * BLOCK_SIZE };
-
-                    // Get texture coordinates for the current block type
-                    Vector2 texCoord = GetTextureCoord(currentBlock.type);
-
-                    // Left face (west) - negative X direction
-                    if (!IsBlockSolid(chunk, x - 1, y, z)) {
-                        vertices[vertexCount + 0] = (Vector3){ blockPosition.x, blockPosition.y, blockPosition.z };
-                        vertices[vertexCount + 1] = (Vector3){ blockPosition.x, blockPosition.y + BLOCK_SIZE, blockPosition.z };
-                        vertices[vertexCount + 2] = (Vector3){ blockPosition.x, blockPosition.y + BLOCK_SIZE, blockPosition.z + BLOCK_SIZE };
-                        vertices[vertexCount + 3] = (Vector3){ blockPosition.x, blockPosition.y, blockPosition.z + BLOCK_SIZE };
-
-                        texcoords[vertexCount + 0] = (Vector2){ texCoord.x, texCoord.y };
-                        texcoords[vertexCount + 1] = (Vector2){ texCoord.x, texCoord.y + BLOCK_TEXTURE_SIZE };
-                        texcoords[vertexCount + 2] = (Vector2){ texCoord.x + BLOCK_TEXTURE_SIZE, texCoord.y + BLOCK_TEXTURE_SIZE };
-                        texcoords[vertexCount + 3] = (Vector2){ texCoord.x + BLOCK_TEXTURE_SIZE, texCoord.y };
-
-                        
-
-                        indices[indexCount + 0] = vertexCount + 0;
-                        indices[indexCount + 1] = vertexCount + 2;
-                        indices[indexCount + 2] = vertexCount + 1;
-                        indices[indexCount + 3] = vertexCount + 0;
-                        indices[indexCount + 4] = vertexCount + 3;
-                        indices[indexCount + 5] = vertexCount + 2;
-
-                        vertexCount += 4;
-                        indexCount += 6;
-                    }
-
-                    // Right face (east) - positive X direction
-                    if (!IsBlockSolid(chunk, x + 1, y, z)) {
-                        vertices[vertexCount + 0] = (Vector3){ blockPosition.x + BLOCK_SIZE, blockPosition.y, blockPosition.z };
-                        vertices[vertexCount + 1] = (Vector3){ blockPosition.x + BLOCK_SIZE, blockPosition.y + BLOCK_SIZE, blockPosition.z };
-                        vertices[vertexCount + 2] = (Vector3){ blockPosition.x + BLOCK_SIZE, blockPosition.y + BLOCK_SIZE, blockPosition.z + BLOCK_SIZE };
-                        vertices[vertexCount + 3] = (Vector3){ blockPosition.x + BLOCK_SIZE, blockPosition.y, blockPosition.z + BLOCK_SIZE };
-
-                        texcoords[vertexCount + 0] = (Vector2){ texCoord.x, texCoord.y };
-                        texcoords[vertexCount + 1] = (Vector2){ texCoord.x, texCoord.y + BLOCK_TEXTURE_SIZE };
-                        texcoords[vertexCount + 2] = (Vector2){ texCoord.x + BLOCK_TEXTURE_SIZE, texCoord.y + BLOCK_TEXTURE_SIZE };
-                        texcoords[vertexCount + 3] = (Vector2){ texCoord.x + BLOCK_TEXTURE_SIZE, texCoord.y };
-
-                        indices[indexCount + 0] = vertexCount + 0;
-                        indices[indexCount + 1] = vertexCount + 1;
-                        indices[indexCount + 2] = vertexCount + 2;
-                        indices[indexCount + 3] = vertexCount + 0;
-                        indices[indexCount + 4] = vertexCount + 2;
-                        indices[indexCount + 5] = vertexCount + 3;
-
-                        vertexCount += 4;
-                        indexCount += 6;
-                    }
-
-                    // Bottom face - negative Y direction
-                    if (!IsBlockSolid(chunk, x, y - 1, z)) {
-                        vertices[vertexCount + 0] = (Vector3){ blockPosition.x, blockPosition.y, blockPosition.z };
-                        vertices[vertexCount + 1] = (Vector3){ blockPosition.x + BLOCK_SIZE, blockPosition.y, blockPosition.z };
-                        vertices[vertexCount + 2] = (Vector3){ blockPosition.x + BLOCK_SIZE, blockPosition.y, blockPosition.z + BLOCK_SIZE };
-                        vertices[vertexCount + 3] = (Vector3){ blockPosition.x, blockPosition.y, blockPosition.z + BLOCK_SIZE };
-
-                        texcoords[vertexCount + 0] = (Vector2){ texCoord.x, texCoord.y };
-                        texcoords[vertexCount + 1] = (Vector2){ texCoord.x + BLOCK_TEXTURE_SIZE, texCoord.y };
-                        texcoords[vertexCount + 2] = (Vector2){ texCoord.x + BLOCK_TEXTURE_SIZE, texCoord.y + BLOCK_TEXTURE_SIZE };
-                        texcoords[vertexCount + 3] = (Vector2){ texCoord.x, texCoord.y + BLOCK_TEXTURE_SIZE };
-
-                        indices[indexCount + 0] = vertexCount + 0;
-                        indices[indexCount + 1] = vertexCount + 1;
-                        indices[indexCount + 2] = vertexCount + 2;
-                        indices[indexCount + 3] = vertexCount + 0;
-                        indices[indexCount + 4] = vertexCount + 2;
-                        indices[indexCount + 5] = vertexCount + 3;
-
-                        vertexCount += 4;
-                        indexCount += 6;
-                    }
-
-                    // Top face - positive Y direction
-                    if (!IsBlockSolid(chunk, x, y + 1, z)) {
-                        vertices[vertexCount + 0] = (Vector3){ blockPosition.x, blockPosition.y + BLOCK_SIZE, blockPosition.z };
-                        vertices[vertexCount + 1] = (Vector3){ blockPosition.x + BLOCK_SIZE, blockPosition.y + BLOCK_SIZE, blockPosition.z };
-                        vertices[vertexCount + 2] = (Vector3){ blockPosition.x + BLOCK_SIZE, blockPosition.y + BLOCK_SIZE, blockPosition.z + BLOCK_SIZE };
-                        vertices[vertexCount + 3] = (Vector3){ blockPosition.x, blockPosition.y + BLOCK_SIZE, blockPosition.z + BLOCK_SIZE };
-
-                        texcoords[vertexCount + 0] = (Vector2){ texCoord.x, texCoord.y };
-                        texcoords[vertexCount + 1] = (Vector2){ texCoord.x, texCoord.y + BLOCK_TEXTURE_SIZE };
-                        texcoords[vertexCount + 2] = (Vector2){ texCoord.x + BLOCK_TEXTURE_SIZE, texCoord.y + BLOCK_TEXTURE_SIZE };
-                        texcoords[vertexCount + 3] = (Vector2){ texCoord.x + BLOCK_TEXTURE_SIZE, texCoord.y };
-
-                        indices[indexCount + 0] = vertexCount + 0;
-                        indices[indexCount + 1] = vertexCount + 2;
-                        indices[indexCount + 2] = vertexCount + 1;
-                        indices[indexCount + 3] = vertexCount + 0;
-                        indices[indexCount + 4] = vertexCount + 3;
-                        indices[indexCount + 5] = vertexCount + 2;
-
-                        vertexCount += 4;
-                        indexCount += 6;
-                    }
-
-                    // Front face (north) - negative Z direction
-                    if (!IsBlockSolid(chunk, x, y, z - 1)) {
-                        vertices[vertexCount + 0] = (Vector3){ blockPosition.x, blockPosition.y, blockPosition.z };
-                        vertices[vertexCount + 1] = (Vector3){ blockPosition.x, blockPosition.y + BLOCK_SIZE, blockPosition.z };
-                        vertices[vertexCount + 2] = (Vector3){ blockPosition.x + BLOCK_SIZE, blockPosition.y + BLOCK_SIZE, blockPosition.z };
-                        vertices[vertexCount + 3] = (Vector3){ blockPosition.x + BLOCK_SIZE, blockPosition.y, blockPosition.z };
-
-                        texcoords[vertexCount + 0] = (Vector2){ texCoord.x, texCoord.y };
-                        texcoords[vertexCount + 1] = (Vector2){ texCoord.x, texCoord.y + BLOCK_TEXTURE_SIZE };
-                        texcoords[vertexCount + 2] = (Vector2){ texCoord.x + BLOCK_TEXTURE_SIZE, texCoord.y + BLOCK_TEXTURE_SIZE };
-                        texcoords[vertexCount + 3] = (Vector2){ texCoord.x + BLOCK_TEXTURE_SIZE, texCoord.y };
-
-                        indices[indexCount + 0] = vertexCount + 0;
-                        indices[indexCount + 1] = vertexCount + 1;
-                        indices[indexCount + 2] = vertexCount + 2;
-                        indices[indexCount + 3] = vertexCount + 0;
-                        indices[indexCount + 4] = vertexCount + 2;
-                        indices[indexCount + 5] = vertexCount + 3;
-
-                        vertexCount += 4;
-                        indexCount += 6;
-                    }
-
-                    // Back face (south) - positive Z direction
-                    if (!IsBlockSolid(chunk, x, y, z + 1)) {
-                        vertices[vertexCount + 0] = (Vector3){ blockPosition.x, blockPosition.y, blockPosition.z + BLOCK_SIZE };
-                        vertices[vertexCount + 1] = (Vector3){ blockPosition.x, blockPosition.y + BLOCK_SIZE, blockPosition.z + BLOCK_SIZE };
-                        vertices[vertexCount + 2] = (Vector3){ blockPosition.x + BLOCK_SIZE, blockPosition.y + BLOCK_SIZE, blockPosition.z + BLOCK_SIZE };
-                        vertices[vertexCount + 3] = (Vector3){ blockPosition.x + BLOCK_SIZE, blockPosition.y, blockPosition.z + BLOCK_SIZE };
-
-                        texcoords[vertexCount + 0] = (Vector2){ texCoord.x, texCoord.y };
-                        texcoords[vertexCount + 1] = (Vector2){ texCoord.x, texCoord.y + BLOCK_TEXTURE_SIZE };
-                        texcoords[vertexCount + 2] = (Vector2){ texCoord.x + BLOCK_TEXTURE_SIZE, texCoord.y + BLOCK_TEXTURE_SIZE };
-                        texcoords[vertexCount + 3] = (Vector2){ texCoord.x + BLOCK_TEXTURE_SIZE, texCoord.y };
-
-                        indices[indexCount + 0] = vertexCount + 0;
-                        indices[indexCount + 1] = vertexCount + 2;
-                        indices[indexCount + 2] = vertexCount + 1;
-                        indices[indexCount + 3] = vertexCount + 0;
-                        indices[indexCount + 4] = vertexCount + 3;
-                        indices[indexCount + 5] = vertexCount + 2;
-
-                        vertexCount += 4;
-                        indexCount += 6;
-                    }
+            const FaceDirection* face = &faceDirections[f];
+            int sectionY = visit.sectionY + face->dy;
+            if (sectionY < 0 || sectionY >= CHUNK_SECTIONS) continue;
+
+            Chunk* chunk = (face->dy != 0) ? visit.chunk : GetChunk(visit.chunk->chunkX + face->dx, visit.chunk->chunkZ + face->dz);
+            if (chunk == NULL) continue;
+
+            ChunkSection* next = &chunk->sections[sectionY];
+            if (next->visibleFrame == occlusionFrame || !IsChunkVisible(frustum, next->boundingBox)) continue;
+
+            next->visibleFrame = occlusionFrame;
+            queue[tail++] = (SectionVisit){ chunk, sectionY, f ^ 1, visit.directions | (1 << f) };
+        }
+    }
+
+    return true;
+}
+// Order chunk meshes by page, then by first vertex
+int CompareChunkMeshes(const void* a, const void* b)
+{
+    const ChunkMesh* meshA = (const ChunkMesh*)a;
+    const ChunkMesh* meshB = (const ChunkMesh*)b;
+    if (meshA->page != meshB->page) return meshA->page - meshB->page;
+    return meshA->firstVertex - meshB->firstVertex;
+}
+// Function to draw all chunk meshes, batched per vertex page
+void DrawChunks(Camera3D camera)
+{
+    // Build the frustum once per frame from the matrices set by BeginMode3D()
+    Matrix viewProjection = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    Frustum frustum = GetFrustum(viewProjection);
+    Matrix blockScale = MatrixScale(BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE);
+    static ChunkMesh draws[CHUNK_CACHE_SIZE * CHUNK_SECTIONS];
+    int drawCount = 0;
+
+    // Find the sections the camera can see into before drawing any of them
+    bool occlusion = occlusionCulling && UpdateSectionVisibility(camera.position, &frustum);
+
+    drawnVertexCount = 0;
+    drawnSectionCount = 0;
+    culledChunkCount = 0;
+    occludedSectionCount = 0;
+    for (int i = 0; i < CHUNK_CACHE_SIZE; i++) {
+        Chunk* chunk = &chunkCache[i];
+        if (!chunk->loaded) continue;
+
+        for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++) {
+            ChunkSection* section = &chunk->sections[sectionY];
+            if (section->mesh.vertexCount == 0) continue; // All-air and buried sections have no mesh
+
+            // Only draw the section if it's visible in the camera's frustum and not hidden behind other sections
+            if (IsChunkVisible(&frustum, section->boundingBox))
+            {
+                if (occlusion && section->visibleFrame != occlusionFrame) {
+                    occludedSectionCount++;
+                    continue;
                 }
+
+                draws[drawCount++] = section->mesh;
+                drawnVertexCount += section->mesh.vertexCount;
+                drawnSectionCount++;
             }
+            else culledChunkCount++;
         }
     }
 
-    chunk->mesh = GenMeshCustom(vertices, texcoords, indices, vertexCount, indexCount);
-    chunk->model = LoadModelFromMesh(chunk->mesh);
-    // Free the temporary arrays
-    MemFree(vertices);
-    MemFree(texcoords);
-    MemFree(indices);
-    chunk->meshNeedsUpdate = false;
+    // Sort the visible ranges by page and position so neighbouring ranges merge into one draw
+    qsort(draws, drawCount, sizeof(ChunkMesh), CompareChunkMeshes);
+
+    // Chunks are drawn straight from their vertex pages, flush raylib's batch first
+    rlDrawRenderBatchActive();
+    rlEnableShader(chunkShader.id);
+    rlActiveTextureSlot(0);
+    rlEnableTexture(BLOCKS.id);
+
+    chunkDrawCallCount = 0;
+    for (int i = 0; i < drawCount;) {
+        // One matrix and one bind per page
+        const ChunkPage* page = &chunkPages[draws[i].page];
+        Matrix model = MatrixMultiply(blockScale, MatrixTranslate(page->regionX * CHUNK_REGION_SIZE * CHUNK_SIZE * BLOCK_SIZE, 0.0f, page->regionZ * CHUNK_REGION_SIZE * CHUNK_SIZE * BLOCK_SIZE));
+        rlSetUniformMatrix(chunkShader.locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(model, viewProjection));
+        BindChunkPage(page);
+
+        int pageIndex = draws[i].page;
+        while (i < drawCount && draws[i].page == pageIndex) {
+            int first = draws[i].firstVertex;
+            int end = first + draws[i].vertexCount;
+            for (i++; i < drawCount && draws[i].page == pageIndex && draws[i].firstVertex == end; i++) end += draws[i].vertexCount;
+
+            DrawChunkPageRange(first, end - first);
+        }
+    }
+
+    rlDisableVertexArray();
+    rlDisableTexture();
+    rlDisableShader();
 }
-// Function to draw all chunk meshes
-void DrawChunks(Camera3D camera)
+// Function to fill a chunk column with terrain, safe to call from worker threads
+void GenerateChunkTerrain(Chunk* chunk, int chunkX, int chunkZ) {
+    int heights[CHUNK_SIZE][CHUNK_SIZE];
+
+    // Get height using Perlin noise, once per column of blocks
+    GetTerrainHeights(chunkX, chunkZ, heights);
+    for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++) {
+        ChunkSection* section = &chunk->sections[sectionY];
+        GenerateTerrainSection(&section->blocks, heights, sectionY);
+        GetBlockStorageConnections(&section->blocks, section->faceConnections);
+    }
+}
+// Function to light a filled chunk column on its own (see LightChunkColumn()), safe to call from worker threads.
+// Sections lit all the same keep a single lightFill value instead of an array.
+void LightChunkTerrain(Chunk* chunk) {
+    unsigned char* types = (unsigned char*)GetJobScratch(2 * COLUMN_VOLUME + LIGHT_COLUMN_QUEUE_SIZE * sizeof(unsigned short));
+    unsigned char* light = types + COLUMN_VOLUME;
+    unsigned short* queue = (unsigned short*)(light + COLUMN_VOLUME);
+
+    for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++) DecodeBlockStorage(&chunk->sections[sectionY].blocks, &types[sectionY * CHUNK_VOLUME]);
+    LightChunkColumn(types, light, queue);
+
+    for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++) {
+        ChunkSection* section = &chunk->sections[sectionY];
+        const unsigned char* sectionLight = &light[sectionY * CHUNK_VOLUME];
+
+        section->lightFill = sectionLight[0];
+        bool uniform = true;
+        for (int i = 1; i < CHUNK_VOLUME && uniform; i++) uniform = (sectionLight[i] == section->lightFill);
+        if (uniform) continue;
+
+        section->light = (unsigned char*)MemAlloc(CHUNK_VOLUME);
+        memcpy(section->light, sectionLight, CHUNK_VOLUME);
+    }
+}
+// Chunk jobs: work runs on a worker thread, completion on the main thread
+void ChunkTerrainJob(void* data)
+{
+    Chunk* chunk = (Chunk*)data;
+    BlockStorage* sections[CHUNK_SECTIONS];
+    for (int i = 0; i < CHUNK_SECTIONS; i++) sections[i] = &chunk->sections[i].blocks;
+
+    // Saved columns are decoded, a corrupt one is generated again
+    chunk->needsSave = (chunk->savedData == NULL) || !DecodeChunkColumn(chunk->savedData, chunk->savedSize, sections);
+    if (chunk->needsSave) {
+        if (chunk->savedData != NULL) TraceLog(LOG_WARNING, "REGION: Chunk column (%i, %i) is corrupt, generated again", chunk->chunkX, chunk->chunkZ);
+        GenerateChunkTerrain(chunk, chunk->chunkX, chunk->chunkZ);
+    }
+    else {
+        for (int i = 0; i < CHUNK_SECTIONS; i++) GetBlockStorageConnections(sections[i], chunk->sections[i].faceConnections);
+    }
+    LightChunkTerrain(chunk);
+}
+void MarkChunkNeighboursDirty(Chunk* chunk);
+void SeedChunkSeamLight(Chunk* chunk);
+void ChunkTerrainJobComplete(void* data)
+{
+    Chunk* chunk = (Chunk*)data;
+    chunk->terrainReady = true;
+    if (chunk->savedData != NULL) MemFree(chunk->savedData);
+    chunk->savedData = NULL;
+    for (int i = 0; i < CHUNK_SECTIONS; i++) chunk->sections[i].meshNeedsUpdate = true;
+    chunk->pendingJobs--;
+
+    // Neighbours meshed before this chunk existed have faces on the shared border
+    MarkChunkNeighboursDirty(chunk);
+
+    // The column was lit as if nothing was around it, let the light across its seams in and out. Only the seeds are
+    // queued here, UpdateBlockEdits() spreads them within lightBudget.
+    SeedChunkSeamLight(chunk);
+}
+void ChunkMeshJob(void* data)
+{
+    ChunkSection* section = (ChunkSection*)data;
+    BuildChunkMesh(section->meshBlocks, section->meshLight, section->meshMode, &section->meshData);
+}
+bool IsChunkPastMeshDistance(const Chunk* chunk);
+void ChunkMeshJobComplete(void* data)
+{
+    ChunkSection* section = (ChunkSection*)data;
+
+    // Columns that fell past chunkMeshDistance while the job ran keep no mesh
+    if (IsChunkPastMeshDistance(&chunkCache[section->chunkIndex])) {
+        if (section->meshData.vertices != NULL) MemFree(section->meshData.vertices);
+        section->meshData = (ChunkMeshBuilder){ 0 };
+        UnloadChunkMesh(&section->mesh);
+        section->meshNeedsUpdate = false;
+        section->meshDropped = true;
+    }
+    else UploadChunkMesh(section, &section->meshData);
+    MemFree(section->meshBlocks);
+    section->meshBlocks = NULL;
+    section->meshLight = NULL;
+    section->jobPending = false;
+    chunkCache[section->chunkIndex].pendingJobs--;
+}
+// Hash bucket of a chunk coordinate
+int GetChunkHash(int chunkX, int chunkZ)
+{
+    return (int)(((unsigned int)chunkX * 73856093U ^ (unsigned int)chunkZ * 19349663U) & (CHUNK_HASH_SIZE - 1));
+}
+// Function to find a resident chunk by chunk coordinate, returns NULL if it is not loaded
+Chunk* GetChunk(int chunkX, int chunkZ)
+{
+    for (int i = chunkHashBuckets[GetChunkHash(chunkX, chunkZ)]; i != -1; i = chunkCache[i].hashNext) {
+        if (chunkCache[i].chunkX == chunkX && chunkCache[i].chunkZ == chunkZ) return &chunkCache[i];
+    }
+    return NULL;
+}
+// Horizontal neighbour offsets, in chunks: -x, +x, -z, +z
+static const int chunkNeighbourOffsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+// Function to request a remesh of every section of every generated neighbour of a chunk
+void MarkChunkNeighboursDirty(Chunk* chunk)
 {
-    for (int x = 0; x < WORLD_WIDTH; x++) {
-        for (int z = 0; z < WORLD_DEPTH; z++) {
-            Chunk* chunk = &worldChunks[x][z];
+    for (int i = 0; i < 4; i++) {
+        Chunk* neighbour = GetChunk(chunk->chunkX + chunkNeighbourOffsets[i][0], chunk->chunkZ + chunkNeighbourOffsets[i][1]);
+        if (neighbour == NULL || !neighbour->terrainReady) continue;
+        for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++) neighbour->sections[sectionY].meshNeedsUpdate = true;
+    }
+}
+// Whether every resident neighbour of a chunk has its blocks, so meshing now will not need a redo right away
+bool AreChunkNeighboursReady(Chunk* chunk)
+{
+    for (int i = 0; i < 4; i++) {
+        Chunk* neighbour = GetChunk(chunk->chunkX + chunkNeighbourOffsets[i][0], chunk->chunkZ + chunkNeighbourOffsets[i][1]);
+        if (neighbour != NULL && !neighbour->terrainReady) return false;
+    }
+    return true;
+}
+// Solid storage standing in for the blocks below the world, so the world floor is never meshed
+static const BlockStorage worldFloorBlocks = { BlockStorageSingle, Stone };
+// Function to get the six neighbours of a section in faceDirections order, main thread only.
+// Missing or generating neighbours and the sky are NULL (air), below the world is solid. Chunks at another
+// level of detail are NULL too, so both sides of an LOD seam keep their border faces and no gap opens.
+void GetChunkSectionNeighbours(Chunk* chunk, int sectionY, const BlockStorage* neighbours[6])
+{
+    for (int f = 0; f < 6; f++) {
+        const FaceDirection* face = &faceDirections[f];
+
+        if (face->dy != 0) {
+            int y = sectionY + face->dy;
+            if (y < 0) neighbours[f] = &worldFloorBlocks;
+            else neighbours[f] = (y < CHUNK_SECTIONS) ? &chunk->sections[y].blocks : NULL;
+        }
+        else {
+            Chunk* neighbour = GetChunk(chunk->chunkX + face->dx, chunk->chunkZ + face->dz);
+            neighbours[f] = (neighbour != NULL && neighbour->terrainReady && neighbour->lod == chunk->lod) ? &neighbour->sections[sectionY].blocks : NULL;
+        }
+    }
+}
+// Function to copy a section's blocks plus a one block border from the sections around it into a
+// PADDED_CHUNK_VOLUME array, main thread only
+void GetChunkMeshBlocks(Chunk* chunk, int sectionY, unsigned char* padded)
+{
+    const BlockStorage* neighbours[6];
+    GetChunkSectionNeighbours(chunk, sectionY, neighbours);
+    PadChunkSection(&chunk->sections[sectionY].blocks, neighbours, chunk->lod, padded);
+}
+// Light of block (x, y, z) of a section
+static inline unsigned char GetSectionLight(const ChunkSection* section, int x, int y, int z)
+{
+    return (section->light != NULL) ? section->light[BLOCK_INDEX(x, y, z)] : section->lightFill;
+}
+// Function to fill the padded light around a full detail section after GetChunkMeshBlocks(), main thread only. Also
+// fills the edge and corner blocks PadChunkSection() leaves as air, the mesher samples them for smooth light and
+// ambient occlusion. Light outside the resident chunks is open sky, below the world it is dark.
+void GetChunkMeshLight(Chunk* chunk, int sectionY, unsigned char* padded, unsigned char* light)
+{
+    Chunk* columns[3][3];
+    for (int dx = -1; dx <= 1; dx++) {
+        for (int dz = -1; dz <= 1; dz++) {
+            Chunk* column = GetChunk(chunk->chunkX + dx, chunk->chunkZ + dz);
+            columns[dx + 1][dz + 1] = (column != NULL && column->terrainReady) ? column : NULL;
+        }
+    }
 
-            // Only update the mesh if it is marked for update
-            if (chunk->meshNeedsUpdate) {
-                GenerateChunkMesh(chunk);
+    for (int x = -1; x <= CHUNK_SIZE; x++) {
+        int columnX = (x < 0) ? 0 : (x < CHUNK_SIZE) ? 1 : 2;
+        int localX = x - (columnX - 1) * CHUNK_SIZE;
+
+        for (int z = -1; z <= CHUNK_SIZE; z++) {
+            int columnZ = (z < 0) ? 0 : (z < CHUNK_SIZE) ? 1 : 2;
+            int localZ = z - (columnZ - 1) * CHUNK_SIZE;
+            Chunk* column = columns[columnX][columnZ];
+
+            for (int y = -1; y <= CHUNK_SIZE; y++) {
+                int index = PADDED_BLOCK_INDEX(x, y, z);
+                int worldY = sectionY * CHUNK_SIZE + y;
+                bool inWorld = (worldY >= 0 && worldY < WORLD_HEIGHT);
+                const ChunkSection* section = (column != NULL && inWorld) ? &column->sections[worldY / CHUNK_SIZE] : NULL;
+
+                if (section != NULL) light[index] = GetSectionLight(section, localX, worldY % CHUNK_SIZE, localZ);
+                else light[index] = (worldY < 0) ? 0 : FULL_SKY_LIGHT;
+
+                // Edges and corners: outside the section along at least two axes
+                int outside = (x < 0 || x >= CHUNK_SIZE) + (y < 0 || y >= CHUNK_SIZE) + (z < 0 || z >= CHUNK_SIZE);
+                if (outside < 2) continue;
+                if (worldY < 0) padded[index] = Stone;
+                else if (section != NULL && column->lod == chunk->lod) padded[index] = GetBlockType(&section->blocks, localX, worldY % CHUNK_SIZE, localZ);
             }
+        }
+    }
+}
+// Whether a section has no visible faces because it and every section around it are completely solid
+bool IsSectionBuried(Chunk* chunk, int sectionY)
+{
+    const BlockStorage* neighbours[6];
+    GetChunkSectionNeighbours(chunk, sectionY, neighbours);
+    return IsChunkSectionBuried(&chunk->sections[sectionY].blocks, neighbours);
+}
+// Whether a section can have faces, all-air and buried sections are never meshed
+bool HasSectionFaces(Chunk* chunk, int sectionY)
+{
+    const BlockStorage* blocks = &chunk->sections[sectionY].blocks;
+    if (blocks->mode == BlockStorageSingle && !blockTypes[blocks->singleType].visible) return false;
+    return !IsSectionBuried(chunk, sectionY);
+}
+// Meshing mode for a chunk, downsampled levels of detail are only useful merged
+int GetChunkMeshingMode(Chunk* chunk)
+{
+    return (chunk->lod > 0) ? MeshingGreedy : meshingMode;
+}
+//Generate mesh section function, builds and uploads on the calling thread
+void GenerateChunkMesh(Chunk* chunk, int sectionY) {
+    unsigned char padded[PADDED_CHUNK_VOLUME];
+    unsigned char light[PADDED_CHUNK_VOLUME];
+    ChunkMeshBuilder builder = { 0 };
+    ChunkSection* section = &chunk->sections[sectionY];
+
+    // Lower levels of detail are meshed without light
+    GetChunkMeshBlocks(chunk, sectionY, padded);
+    if (chunk->lod == 0) GetChunkMeshLight(chunk, sectionY, padded, light);
+    BuildChunkMesh(padded, (chunk->lod == 0) ? light : NULL, GetChunkMeshingMode(chunk), &builder);
+    UploadChunkMesh(section, &builder);
+    section->meshNeedsUpdate = false;
+}
+// Request a remesh of a section for an edit, it is picked up by the next UpdateBlockEdits()
+void QueueSectionEdit(ChunkSection* section)
+{
+    section->meshNeedsUpdate = true;
+    if (section->edited || editedSectionCount == MAX_EDITED_SECTIONS) return; // Full: left to the mesh jobs
 
-            // Only draw the chunk if it's visible in the camera's frustum
-            if (IsChunkVisible(camera, chunk->boundingBox))
-            {
-                SetMaterialTexture(&chunk->model.materials[0], MATERIAL_MAP_DIFFUSE, BLOCKS);
-                DrawModel(chunk->model, chunk->position, 1.0f, WHITE);
+    section->edited = true;
+    editedSections[editedSectionCount++] = section;
+}
+// Function to request a remesh of every section whose mesh reads block (x, y, z) of a chunk (y is the height in the
+// column): its own section plus, on a section border, the sections across it, diagonally too since meshes sample
+// the corners for light. Edits are remeshed in the next UpdateBlockEdits(), otherwise by the mesh jobs.
+void QueueBlockRemesh(Chunk* chunk, int x, int y, int z, bool edit)
+{
+    int sectionY = y / CHUNK_SIZE;
+    int localY = y % CHUNK_SIZE;
+    int minX = (x == 0) ? -1 : 0, maxX = (x == CHUNK_SIZE - 1) ? 1 : 0;
+    int minY = (localY == 0) ? -1 : 0, maxY = (localY == CHUNK_SIZE - 1) ? 1 : 0;
+    int minZ = (z == 0) ? -1 : 0, maxZ = (z == CHUNK_SIZE - 1) ? 1 : 0;
+
+    for (int dx = minX; dx <= maxX; dx++) {
+        for (int dz = minZ; dz <= maxZ; dz++) {
+            Chunk* column = (dx == 0 && dz == 0) ? chunk : GetChunk(chunk->chunkX + dx, chunk->chunkZ + dz);
+            if (column == NULL || !column->terrainReady) continue;
+
+            for (int dy = minY; dy <= maxY; dy++) {
+                if (sectionY + dy < 0 || sectionY + dy >= CHUNK_SECTIONS) continue;
+                ChunkSection* section = &column->sections[sectionY + dy];
+                if (edit) QueueSectionEdit(section);
+                else section->meshNeedsUpdate = true;
             }
         }
     }
 }
-// Function to initialize chunks with random block types
-void InitChunks() {
+// Function to change one block of a generated chunk and queue the remeshes and light changes it needs, main thread
+// only. y is the height in the column. Only the sections that read the block are remeshed, see QueueBlockRemesh().
+// Edits are coalesced: each section is remeshed once per frame however many change.
+void SetChunkBlock(Chunk* chunk, int x, int y, int z, unsigned char type)
+{
+    if (!chunk->terrainReady) return;
+
+    int sectionY = y / CHUNK_SIZE;
+    int localY = y % CHUNK_SIZE;
+    ChunkSection* section = &chunk->sections[sectionY];
+    if (GetBlockType(&section->blocks, x, localY, z) == type) return;
+
+    SetBlockType(&section->blocks, x, localY, z, type);
+    section->connectionsNeedUpdate = true;
+    chunk->needsSave = true;
+    QueueBlockRemesh(chunk, x, y, z, true);
+    QueueBlockLightChange(chunk->chunkX * CHUNK_SIZE + x, y, chunk->chunkZ * CHUNK_SIZE + z, type);
+}
+// Function to get the block type at a world block coordinate. Blocks of chunks that are not resident or not
+// generated yet read as air, below the world reads as stone.
+unsigned char GetBlock(int x, int y, int z)
+{
+    if (y < 0) return Stone;
+    if (y >= WORLD_HEIGHT) return Air;
 
-    
+    int chunkX = (int)floorf(x / (float)CHUNK_SIZE);
+    int chunkZ = (int)floorf(z / (float)CHUNK_SIZE);
+    Chunk* chunk = GetChunk(chunkX, chunkZ);
+    if (chunk == NULL || !chunk->terrainReady) return Air;
 
-    for (int x = 0; x < WORLD_WIDTH; x++) {
-        for (int z = 0; z < WORLD_DEPTH; z++) {
+    return GetBlockType(&chunk->sections[y / CHUNK_SIZE].blocks, x - chunkX * CHUNK_SIZE, y % CHUNK_SIZE, z - chunkZ * CHUNK_SIZE);
+}
+// Function to set the block type at a world block coordinate, main thread only. Returns false when the block is
+// outside the world or its chunk is not resident and generated. The remesh happens in the next UpdateChunkJobs().
+bool SetBlock(int x, int y, int z, unsigned char type)
+{
+    if (y < 0 || y >= WORLD_HEIGHT) return false;
 
+    int chunkX = (int)floorf(x / (float)CHUNK_SIZE);
+    int chunkZ = (int)floorf(z / (float)CHUNK_SIZE);
+    Chunk* chunk = GetChunk(chunkX, chunkZ);
+    if (chunk == NULL || !chunk->terrainReady) return false;
 
-            /* if (worldChunks[x][z].mesh.vertexCount > 0) {
-                 UnloadMesh(worldChunks[x][z].mesh);
-             }*/
+    SetChunkBlock(chunk, x - chunkX * CHUNK_SIZE, y, z - chunkZ * CHUNK_SIZE, type);
+    return true;
+}
+// Light callbacks for LizardLight.h, main thread only. Above the world is open sky, below it and chunks that are
+// not resident or generated are dark and cannot be lit.
+unsigned char GetLight(int x, int y, int z)
+{
+    if (y >= WORLD_HEIGHT) return FULL_SKY_LIGHT;
+    if (y < 0) return 0;
 
-            worldChunks[x][z].position = (Vector3){ x * CHUNK_SIZE * BLOCK_SIZE, 0, z * CHUNK_SIZE * BLOCK_SIZE };
-            worldChunks[x][z].boundingBox =
-                (BoundingBox)
-            {
-                (Vector3) {
-                    worldChunks[x][z].position.x, 0, worldChunks[x][z].position.z
-                },
-                (Vector3) {
-                    worldChunks[x][z].position.x + CHUNK_SIZE * BLOCK_SIZE, CHUNK_SIZE* BLOCK_SIZE, worldChunks[x][z].position.z + CHUNK_SIZE * BLOCK_SIZE
+    int chunkX = (int)floorf(x / (float)CHUNK_SIZE);
+    int chunkZ = (int)floorf(z / (float)CHUNK_SIZE);
+    Chunk* chunk = GetChunk(chunkX, chunkZ);
+    if (chunk == NULL || !chunk->terrainReady) return 0;
+
+    return GetSectionLight(&chunk->sections[y / CHUNK_SIZE], x - chunkX * CHUNK_SIZE, y % CHUNK_SIZE, z - chunkZ * CHUNK_SIZE);
+}
+bool SetLight(int x, int y, int z, unsigned char light)
+{
+    if (y < 0 || y >= WORLD_HEIGHT) return false;
+
+    int chunkX = (int)floorf(x / (float)CHUNK_SIZE);
+    int chunkZ = (int)floorf(z / (float)CHUNK_SIZE);
+    Chunk* chunk = GetChunk(chunkX, chunkZ);
+    if (chunk == NULL || !chunk->terrainReady) return false;
+
+    int localX = x - chunkX * CHUNK_SIZE;
+    int localZ = z - chunkZ * CHUNK_SIZE;
+    ChunkSection* section = &chunk->sections[y / CHUNK_SIZE];
+    if (GetSectionLight(section, localX, y % CHUNK_SIZE, localZ) == light) return true;
+
+    // Uniformly lit sections get their own array on the first change
+    if (section->light == NULL) {
+        section->light = (unsigned char*)MemAlloc(CHUNK_VOLUME);
+        memset(section->light, section->lightFill, CHUNK_VOLUME);
+    }
+    section->light[BLOCK_INDEX(localX, y % CHUNK_SIZE, localZ)] = light;
+    QueueBlockRemesh(chunk, localX, y, localZ, lightEditRemesh);
+    return true;
+}
+// Function to queue the blocks on both sides of the seams between a newly lit chunk and its generated neighbours
+// whose light reaches across, UpdateLight() then spreads it over the next frames
+void SeedChunkSeamLight(Chunk* chunk)
+{
+    for (int i = 0; i < 4; i++) {
+        int dx = chunkNeighbourOffsets[i][0];
+        int dz = chunkNeighbourOffsets[i][1];
+        Chunk* neighbour = GetChunk(chunk->chunkX + dx, chunk->chunkZ + dz);
+        if (neighbour == NULL || !neighbour->terrainReady) continue;
+
+        for (int k = 0; k < CHUNK_SIZE; k++) {
+            // Border block of the chunk and the neighbour block across the seam from it
+            int x = (dx < 0) ? 0 : (dx > 0) ? CHUNK_SIZE - 1 : k;
+            int z = (dz < 0) ? 0 : (dz > 0) ? CHUNK_SIZE - 1 : k;
+            int acrossX = (dx != 0) ? CHUNK_SIZE - 1 - x : x;
+            int acrossZ = (dz != 0) ? CHUNK_SIZE - 1 - z : z;
+
+            for (int y = 0; y < WORLD_HEIGHT; y++) {
+                const ChunkSection* section = &chunk->sections[y / CHUNK_SIZE];
+                const ChunkSection* across = &neighbour->sections[y / CHUNK_SIZE];
+                unsigned char light = GetSectionLight(section, x, y % CHUNK_SIZE, z);
+                unsigned char acrossLight = GetSectionLight(across, acrossX, y % CHUNK_SIZE, acrossZ);
+
+                if (IsLightSpreading(light, acrossLight, GetBlockType(&across->blocks, acrossX, y % CHUNK_SIZE, acrossZ))) {
+                    QueueLightSeed(chunk->chunkX * CHUNK_SIZE + x, y, chunk->chunkZ * CHUNK_SIZE + z);
                 }
-            };
-
-            // Generate blocks based on Perlin noise and island falloff
-            for (int bx = 0; bx < CHUNK_SIZE; bx++) {
-                for (int bz = 0; bz < CHUNK_SIZE; bz++) {
-                    // Calculate world coordinates
-                    int worldX = x * CHUNK_SIZE + bx;
-                    int worldZ = z * CHUNK_SIZE + bz;
-
-                    // Get height using Perlin noise and falloff
-                    float height = GetHeight(worldX, worldZ);
-                    int heightInt = (int)height;
-
-                    for (int by = 0; by < CHUNK_SIZE; by++) {
-                        // Set block types based on height
-                        if (by < heightInt)
-                        {
-                            if (by == heightInt - 1) {
-                                worldChunks[x][z].blocks[bx][by][bz].type = Grass; // Top layer
-                            }
-                            else if (by >= heightInt - 3) {
-                                worldChunks[x][z].blocks[bx][by][bz].type = Dirt; // Below top layer
-                            }
-                            else {
-                                worldChunks[x][z].blocks[bx][by][bz].type = Stone; // Lower layers
-                            }
-                        }
-                        else {
-                            worldChunks[x][z].blocks[bx][by][bz].type = Air; // Air above the terrain
-                        }
-                    }
+                if (IsLightSpreading(acrossLight, light, GetBlockType(&section->blocks, x, y % CHUNK_SIZE, z))) {
+                    QueueLightSeed(neighbour->chunkX * CHUNK_SIZE + acrossX, y, neighbour->chunkZ * CHUNK_SIZE + acrossZ);
                 }
             }
+        }
+    }
+}
+// Function to set every block in the box from min to max (inclusive, world block coordinates), returns the number
+// of blocks set. Each section touched is remeshed once, however many of its blocks change.
+int FillBlocks(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, unsigned char type)
+{
+    int count = 0;
+    for (int x = minX; x <= maxX; x++) {
+        for (int y = minY; y <= maxY; y++) {
+            for (int z = minZ; z <= maxZ; z++) count += SetBlock(x, y, z, type);
+        }
+    }
+    return count;
+}
+// Function to move the camera in FPSMode: the usual movement keys, but the camera's box is stopped by blocks
+void UpdateFPSCamera(void)
+{
+    Vector3 forward = Vector3Subtract(ViewCam.target, ViewCam.position);
+    forward.y = 0.0f;
+    forward = Vector3Normalize(forward);
+    Vector3 right = Vector3CrossProduct(forward, (Vector3){ 0.0f, 1.0f, 0.0f });
+
+    Vector3 motion = { 0 };
+    if (IsKeyDown(ForwardKey)) motion = Vector3Add(motion, forward);
+    if (IsKeyDown(BackwardKey)) motion = Vector3Subtract(motion, forward);
+    if (IsKeyDown(RightKey)) motion = Vector3Add(motion, right);
+    if (IsKeyDown(LeftKey)) motion = Vector3Subtract(motion, right);
+    if (IsKeyDown(KEY_SPACE)) motion.y += 1.0f;
+    if (IsKeyDown(KEY_LEFT_CONTROL)) motion.y -= 1.0f;
+    motion = Vector3Scale(motion, (IsKeyDown(KEY_LEFT_SHIFT) ? 33.0f : 10.0f) * GetFrameTime());
+
+    BoundingBox box = { Vector3Add(ViewCam.position, playerBox.min), Vector3Add(ViewCam.position, playerBox.max) };
+    motion = MoveBoxThroughBlocks(box, motion, GetBlock);
+    UpdateLizardFreeCam(FPSMode, Vector3Add(ViewCam.position, motion));
+}
+// Function to find the block under the cursor and break (left click) or place (middle click, with shift a lamp) blocks with it
+void UpdateBlockPicking(void)
+{
+    Ray ray = GetMouseRay(GetMousePosition(), ViewCam);
+    if (cameraMode == FPSMode) ray = (Ray){ ViewCam.position, Vector3Normalize(Vector3Subtract(ViewCam.target, ViewCam.position)) };
+
+    pickedBlock = RaycastBlocks(ray, BLOCK_PICK_DISTANCE, GetBlock);
+    if (!pickedBlock.hit) return;
+
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) SetBlock(pickedBlock.blockX, pickedBlock.blockY, pickedBlock.blockZ, Air);
+    if (IsMouseButtonPressed(MOUSE_BUTTON_MIDDLE)) {
+        int x = pickedBlock.blockX + (int)pickedBlock.normal.x;
+        int y = pickedBlock.blockY + (int)pickedBlock.normal.y;
+        int z = pickedBlock.blockZ + (int)pickedBlock.normal.z;
+
+        // Never place a block inside the walking camera
+        BoundingBox block = { { (float)x, (float)y, (float)z }, { x + 1.0f, y + 1.0f, z + 1.0f } };
+        BoundingBox player = { Vector3Add(ViewCam.position, playerBox.min), Vector3Add(ViewCam.position, playerBox.max) };
+        if (cameraMode != FPSMode || !CheckCollisionBoxes(block, player)) SetBlock(x, y, z, IsKeyDown(KEY_LEFT_SHIFT) ? Lamp : Dirt);
+    }
+}
+// Function to apply the block edits made since the last frame: refresh the connectivity of changed sections and
+// remesh edited sections on the main thread, within editRemeshBudget. Sections past the budget or with a mesh
+// job running keep meshNeedsUpdate and are sent to the workers instead.
+void UpdateBlockEdits(void)
+{
+    // Relight around the edits first, sections whose light changed join the remesh. Frames without edits only
+    // spread seam light, its sections go to the workers.
+    lightEditRemesh = (editedSectionCount > 0);
+    UpdateLight(lightBudget);
+    lightEditRemesh = false;
+
+    double startTime = GetTime();
+
+    for (int i = 0; i < editedSectionCount; i++) {
+        ChunkSection* section = editedSections[i];
+        if (section == NULL) continue; // Evicted since the edit
+        section->edited = false;
+
+        if (section->connectionsNeedUpdate) {
+            GetBlockStorageConnections(&section->blocks, section->faceConnections);
+            section->connectionsNeedUpdate = false;
+        }
+
+        Chunk* chunk = &chunkCache[section->chunkIndex];
+        if (!section->meshNeedsUpdate || section->jobPending || !AreChunkNeighboursReady(chunk)) continue;
+        if (GetTime() - startTime > editRemeshBudget) continue;
+
+        if (HasSectionFaces(chunk, section->sectionY)) GenerateChunkMesh(chunk, section->sectionY);
+        else {
+            UnloadChunkMesh(&section->mesh);
+            section->meshNeedsUpdate = false;
+        }
+    }
+
+    editedSectionCount = 0;
+}
+// Remove a chunk from the LRU list
+void UnlinkChunkLru(int index)
+{
+    Chunk* chunk = &chunkCache[index];
+    if (chunk->lruPrev != -1) chunkCache[chunk->lruPrev].lruNext = chunk->lruNext;
+    else chunkLruHead = chunk->lruNext;
+    if (chunk->lruNext != -1) chunkCache[chunk->lruNext].lruPrev = chunk->lruPrev;
+    else chunkLruTail = chunk->lruPrev;
+    chunk->lruPrev = -1;
+    chunk->lruNext = -1;
+}
+// Insert an unlinked chunk at the front of the LRU list
+void LinkChunkLru(int index)
+{
+    Chunk* chunk = &chunkCache[index];
+    chunk->lruPrev = -1;
+    chunk->lruNext = chunkLruHead;
+    if (chunkLruHead != -1) chunkCache[chunkLruHead].lruPrev = index;
+    chunkLruHead = index;
+    if (chunkLruTail == -1) chunkLruTail = index;
+}
+// Mark a resident chunk as used this frame and move it to the front of the LRU list
+void TouchChunk(int index)
+{
+    chunkCache[index].lastUsedFrame = chunkCacheFrame;
+    if (chunkLruHead == index) return;
+
+    UnlinkChunkLru(index);
+    LinkChunkLru(index);
+}
+// Function to write a generated chunk column to its region file, main thread only
+void SaveChunk(Chunk* chunk)
+{
+    if (!chunk->terrainReady || !chunk->needsSave) return;
+    if (regionDirectory[0] == '\0') return; // In memory only world, see InitRegionFiles()
+
+    const BlockStorage* sections[CHUNK_SECTIONS];
+    for (int i = 0; i < CHUNK_SECTIONS; i++) sections[i] = &chunk->sections[i].blocks;
+
+    int size = 0;
+    unsigned char* data = EncodeChunkColumn(sections, &size);
+    if (WriteRegionChunk(chunk->chunkX, chunk->chunkZ, data, size)) chunk->needsSave = false;
+    MemFree(data);
+}
+// Function to save every resident chunk that changed, before exiting
+void SaveChunks(void)
+{
+    for (int i = 0; i < CHUNK_CACHE_SIZE; i++) {
+        if (chunkCache[i].loaded) SaveChunk(&chunkCache[i]);
+    }
+    UpdateRegionFiles(true);
+}
+// Function to save the changed resident chunks every CHUNK_AUTOSAVE_INTERVAL seconds, so edits near the player
+// survive a crash or a closed tab. A pass is spread over frames, at most chunkSaveBudget seconds each.
+void UpdateChunkAutosave(void)
+{
+    if (regionDirectory[0] == '\0') return; // In memory only world, see InitRegionFiles()
+
+    if (chunkAutosaveSlot < 0) {
+        if (GetTime() - chunkAutosaveTime < CHUNK_AUTOSAVE_INTERVAL) return;
+        chunkAutosaveTime = GetTime();
+        chunkAutosaveSlot = 0;
+    }
+
+    double startTime = GetTime();
+    while (chunkAutosaveSlot < CHUNK_CACHE_SIZE && GetTime() - startTime < chunkSaveBudget) {
+        Chunk* chunk = &chunkCache[chunkAutosaveSlot++];
+        if (chunk->loaded) SaveChunk(chunk);
+    }
+    if (chunkAutosaveSlot == CHUNK_CACHE_SIZE) chunkAutosaveSlot = -1;
+}
+#if defined(PLATFORM_WEB)
+// Web: the main loop never returns, so save everything when the page is hidden or closed
+EMSCRIPTEN_KEEPALIVE void OnPageHidden(void)
+{
+    SaveChunks();
+}
+#endif
+// Save a chunk if needed, unload its GPU data and return its slot to the free list
+void EvictChunk(int index)
+{
+    Chunk* chunk = &chunkCache[index];
+    SaveChunk(chunk);
+
+    // Remove from its hash bucket
+    int* link = &chunkHashBuckets[GetChunkHash(chunk->chunkX, chunk->chunkZ)];
+    while (*link != index) link = &chunkCache[*link].hashNext;
+    *link = chunk->hashNext;
+
+    UnlinkChunkLru(index);
+
+    for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++) {
+        UnloadChunkMesh(&chunk->sections[sectionY].mesh);
+        FreeBlockStorage(&chunk->sections[sectionY].blocks);
+        MemFree(chunk->sections[sectionY].light);
+        chunk->sections[sectionY].light = NULL;
+    }
+    chunk->loaded = false;
+
+    // The slot is reused by the next chunk, forget its pending edits
+    for (int i = 0; i < editedSectionCount; i++) {
+        if (editedSections[i] != NULL && editedSections[i]->chunkIndex == index) {
+            editedSections[i]->edited = false;
+            editedSections[i] = NULL;
+        }
+    }
+
+    freeChunkSlots[freeChunkSlotCount++] = index;
+    residentChunkCount--;
+}
+// Function to load and generate a chunk, evicting the least recently used one if the cache is full.
+// Returns NULL when every resident chunk is still needed this frame, or while saved chunks cannot be read yet.
+Chunk* LoadChunk(int chunkX, int chunkZ)
+{
+    // Web: a column generated before IndexedDB is loaded would overwrite its save when evicted
+    if (!regionFilesReady) return NULL;
+
+    if (freeChunkSlotCount == 0) {
+        // Evict the least recently used chunk that is neither needed this frame nor busy in a job
+        int victim = chunkLruTail;
+        while (victim != -1 && chunkCache[victim].pendingJobs > 0) victim = chunkCache[victim].lruPrev;
+        if (victim == -1 || chunkCache[victim].lastUsedFrame == chunkCacheFrame) return NULL;
+        EvictChunk(victim);
+    }
+
+    int index = freeChunkSlots[--freeChunkSlotCount];
+    Chunk* chunk = &chunkCache[index];
+    chunk->loaded = true;
+    chunk->chunkX = chunkX;
+    chunk->chunkZ = chunkZ;
+    chunk->lod = 0;
+
+    int hash = GetChunkHash(chunkX, chunkZ);
+    chunk->hashNext = chunkHashBuckets[hash];
+    chunkHashBuckets[hash] = index;
+
+    chunk->lastUsedFrame = chunkCacheFrame;
+    LinkChunkLru(index);
+    residentChunkCount++;
+
+    chunk->position = (Vector3){ chunkX * CHUNK_SIZE * BLOCK_SIZE, 0, chunkZ * CHUNK_SIZE * BLOCK_SIZE };
+    for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++) {
+        ChunkSection* section = &chunk->sections[sectionY];
+        float bottom = sectionY * CHUNK_SIZE * BLOCK_SIZE;
+        section->boundingBox =
+            (BoundingBox)
+        {
+            (Vector3) {
+                chunk->position.x, bottom, chunk->position.z
+            },
+            (Vector3) {
+                chunk->position.x + CHUNK_SIZE * BLOCK_SIZE, bottom + CHUNK_SIZE * BLOCK_SIZE, chunk->position.z + CHUNK_SIZE * BLOCK_SIZE
+            }
+        };
+        section->chunkIndex = index;
+        section->sectionY = sectionY;
+        section->meshNeedsUpdate = false;
+        section->meshDropped = false;
+    }
 
-            // Create a default mesh and mark it for update
-            //worldChunks[x][z].mesh = GenMeshCube(1.0f, 1.0f, 1.0f);  // Placeholder mesh
-            worldChunks[x][z].meshNeedsUpdate = true;
+    // Fill the blocks on a worker from the region file or the generator, the sections are meshed once they are ready
+    chunk->terrainReady = false;
+    chunk->savedData = ReadRegionChunk(chunkX, chunkZ, &chunk->savedSize);
+    chunk->pendingJobs++;
+    if (!ScheduleJob(ChunkTerrainJob, ChunkTerrainJobComplete, chunk)) {
+        ChunkTerrainJob(chunk);
+        ChunkTerrainJobComplete(chunk);
+    }
+    return chunk;
+}
+// Function to sum the block data of all resident chunks, in bytes
+int GetResidentBlockBytes(void)
+{
+    int bytes = 0;
+    for (int i = 0; i < CHUNK_CACHE_SIZE; i++) {
+        if (!chunkCache[i].loaded || !chunkCache[i].terrainReady) continue;
+        for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++) bytes += GetBlockStorageSize(&chunkCache[i].sections[sectionY].blocks);
+    }
+    return bytes;
+}
+// Function to initialize the chunk cache with every slot free
+void InitChunks() {
+    for (int i = 0; i < CHUNK_HASH_SIZE; i++) chunkHashBuckets[i] = -1;
+
+    freeChunkSlotCount = 0;
+    for (int i = CHUNK_CACHE_SIZE - 1; i >= 0; i--) {
+        chunkCache[i] = (Chunk){ 0 };
+        chunkCache[i].hashNext = -1;
+        chunkCache[i].lruPrev = -1;
+        chunkCache[i].lruNext = -1;
+        freeChunkSlots[freeChunkSlotCount++] = i;
+    }
+
+    chunkLruHead = -1;
+    chunkLruTail = -1;
+    residentChunkCount = 0;
+}
+// Chunk column waiting for streaming work, see GetChunkPriority()
+typedef struct {
+    int chunkX, chunkZ;
+    int index; // Slot in chunkCache, -1 for columns still to be loaded
+    float priority;
+} ChunkRequest;
+ChunkRequest chunkRequests[CHUNK_CACHE_SIZE];
+int CompareChunkRequests(const void* a, const void* b)
+{
+    float difference = ((const ChunkRequest*)a)->priority - ((const ChunkRequest*)b)->priority;
+    return (difference > 0.0f) - (difference < 0.0f);
+}
+// Horizontal offset from a position to the centre of a chunk column, in chunks
+Vector2 GetChunkOffset(int chunkX, int chunkZ, Vector3 position)
+{
+    return (Vector2){
+        ((chunkX + 0.5f) * CHUNK_SIZE * BLOCK_SIZE - position.x) / (CHUNK_SIZE * BLOCK_SIZE),
+        ((chunkZ + 0.5f) * CHUNK_SIZE * BLOCK_SIZE - position.z) / (CHUNK_SIZE * BLOCK_SIZE)
+    };
+}
+// Streaming priority of a chunk column, lower goes first: its distance to the camera in chunks, tripled outside
+// the camera's horizontal field of view so what is on screen fills in first, the camera's surroundings included
+float GetChunkPriority(int chunkX, int chunkZ, Camera3D camera)
+{
+    Vector2 offset = GetChunkOffset(chunkX, chunkZ, camera.position);
+    float distance = Vector2Length(offset);
+    if (distance < 1.5f) return distance;
+
+    // Half the horizontal field of view, widened by the half width of a column at that distance
+    Vector2 forward = Vector2Normalize((Vector2){ camera.target.x - camera.position.x, camera.target.z - camera.position.z });
+    float aspect = (float)GetScreenWidth() / (float)GetScreenHeight();
+    float halfAngle = atanf(tanf(camera.fovy * 0.5f * DEG2RAD) * aspect) + asinf(0.71f / distance);
+    bool visible = Vector2DotProduct(offset, forward) >= cosf(fminf(halfAngle, PI)) * distance;
+
+    return visible ? distance : distance * 3.0f;
+}
+// Function to stream chunks around the camera: keep every chunk within chunkLoadRadius resident and load missing
+// ones by GetChunkPriority(), at most MAX_CHUNK_LOADS_PER_FRAME and chunkLoadBudget per call
+void UpdateChunkCache(Camera3D camera)
+{
+    chunkCacheFrame++;
+    chunkLoadCount = 0;
+
+    int centerX = (int)floorf(camera.position.x / (CHUNK_SIZE * BLOCK_SIZE));
+    int centerZ = (int)floorf(camera.position.z / (CHUNK_SIZE * BLOCK_SIZE));
+    int radius = chunkLoadRadius;
+
+    // Touch every resident chunk in range first so none of them is picked for eviction, and list the missing ones
+    int requestCount = 0;
+    for (int dx = -radius; dx <= radius; dx++) {
+        for (int dz = -radius; dz <= radius; dz++) {
+            if (dx * dx + dz * dz > radius * radius) continue;
+            Chunk* chunk = GetChunk(centerX + dx, centerZ + dz);
+            if (chunk != NULL) TouchChunk((int)(chunk - chunkCache));
+            else if (requestCount < CHUNK_CACHE_SIZE) {
+                chunkRequests[requestCount++] = (ChunkRequest){ centerX + dx, centerZ + dz, -1, GetChunkPriority(centerX + dx, centerZ + dz, camera) };
+            }
         }
     }
+    if (requestCount == 0) return;
+
+    qsort(chunkRequests, requestCount, sizeof(ChunkRequest), CompareChunkRequests);
+
+    double startTime = GetTime();
+    for (int i = 0; i < requestCount; i++) {
+        if (chunkLoadCount >= MAX_CHUNK_LOADS_PER_FRAME || GetTime() - startTime > chunkLoadBudget) return;
+        if (LoadChunk(chunkRequests[i].chunkX, chunkRequests[i].chunkZ) == NULL) return;
+        chunkLoadCount++;
+    }
+}
+// Whether streaming has caught up with the camera: nothing was loaded last frame and no chunk is waiting for its
+// blocks or meshes
+bool IsWorldLoaded(void)
+{
+    if (residentChunkCount == 0 || chunkLoadCount > 0 || jobsInFlight > 0 || IsLightPending()) return false;
+
+    for (int i = 0; i < CHUNK_CACHE_SIZE; i++) {
+        Chunk* chunk = &chunkCache[i];
+        if (!chunk->loaded) continue;
+        if (!chunk->terrainReady) return false;
+        for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++) {
+            if (chunk->sections[sectionY].meshNeedsUpdate) return false;
+        }
+    }
+    return true;
+}
+// Level of detail for a chunk at the given distance to the camera, in chunks. Levels get finer as soon as a
+// chunk crosses a threshold but only coarser half a chunk past it, so the camera moving along a threshold
+// does not remesh the same chunks every frame.
+int GetChunkLod(float distance, int currentLod)
+{
+    int lod = 0;
+    while (lod < MAX_CHUNK_LOD && distance >= chunkLodDistances[lod]) lod++;
+
+    if (lod > currentLod && distance < chunkLodDistances[lod - 1] + 0.5f) lod--;
+    return lod;
+}
+// Function to pick the level of detail of every resident chunk from its distance to position and remesh the
+// chunks that change level, along with their neighbours whose seams change
+void UpdateChunkLods(Vector3 position)
+{
+    float cameraX = position.x / (CHUNK_SIZE * BLOCK_SIZE);
+    float cameraZ = position.z / (CHUNK_SIZE * BLOCK_SIZE);
+
+    for (int i = 0; i < CHUNK_CACHE_SIZE; i++) {
+        Chunk* chunk = &chunkCache[i];
+        if (!chunk->loaded) continue;
+
+        float dx = chunk->chunkX + 0.5f - cameraX;
+        float dz = chunk->chunkZ + 0.5f - cameraZ;
+        int lod = GetChunkLod(sqrtf(dx * dx + dz * dz), chunk->lod);
+        if (lod == chunk->lod) continue;
+
+        chunk->lod = lod;
+        if (chunk->terrainReady) {
+            for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++) chunk->sections[sectionY].meshNeedsUpdate = true;
+        }
+        MarkChunkNeighboursDirty(chunk);
+    }
+}
+// Whether a column is too far from the camera to be meshed under the VRAM budget
+bool IsChunkPastMeshDistance(const Chunk* chunk)
+{
+    return Vector2Length(GetChunkOffset(chunk->chunkX, chunk->chunkZ, chunkMeshPosition)) >= chunkMeshDistance;
+}
+// Function to drop the meshes of a column for the VRAM budget, GL thread only. Its sections are rebuilt once the
+// column is back within chunkMeshDistance, jobs already running for them discard their result.
+void DropChunkMeshes(Chunk* chunk)
+{
+    for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++) {
+        ChunkSection* section = &chunk->sections[sectionY];
+        if (section->mesh.vertexCount == 0 && !section->meshNeedsUpdate && !section->jobPending) continue;
+
+        UnloadChunkMesh(&section->mesh);
+        section->meshNeedsUpdate = false;
+        section->meshDropped = true;
+    }
+}
+// Function to keep the chunk meshes under chunkVramBudget, GL thread only. Usage counts the page ranges meshes hold,
+// so each dropped column frees its share right away. While over the budget the farthest meshed column is dropped
+// and chunkMeshDistance shrinks to it. The distance only widens again, half a chunk per chunk the camera moves,
+// once usage is under three quarters of the budget, so a still camera never meshes past a distance that overflowed.
+void EnforceChunkVramBudget(Vector3 position)
+{
+    int centerX = (int)floorf(position.x / (CHUNK_SIZE * BLOCK_SIZE));
+    int centerZ = (int)floorf(position.z / (CHUNK_SIZE * BLOCK_SIZE));
+
+    if (chunkMeshDistance < FLT_MAX && (centerX != chunkMeshCenterX || centerZ != chunkMeshCenterZ)) {
+        if (chunkVramUsedBytes < chunkVramBudget / 4 * 3) chunkMeshDistance += 0.5f;
+        if (chunkMeshDistance > chunkLoadRadius + 1) chunkMeshDistance = FLT_MAX;
+        chunkMeshCenterX = centerX;
+        chunkMeshCenterZ = centerZ;
+    }
+
+    while (chunkVramUsedBytes > chunkVramBudget) {
+        int farthest = -1;
+        float farthestDistance = 0.0f;
+        for (int i = 0; i < CHUNK_CACHE_SIZE; i++) {
+            Chunk* chunk = &chunkCache[i];
+            if (!chunk->loaded) continue;
+
+            bool meshed = false;
+            for (int sectionY = 0; sectionY < CHUNK_SECTIONS && !meshed; sectionY++) meshed = (chunk->sections[sectionY].mesh.vertexCount > 0);
+            if (!meshed) continue;
+
+            float distance = Vector2Length(GetChunkOffset(chunk->chunkX, chunk->chunkZ, position));
+            if (farthest < 0 || distance > farthestDistance) {
+                farthest = i;
+                farthestDistance = distance;
+            }
+        }
+        if (farthest < 0) break;
+
+        DropChunkMeshes(&chunkCache[farthest]);
+        if (farthestDistance < chunkMeshDistance) chunkMeshDistance = farthestDistance;
+        chunkMeshCenterX = centerX;
+        chunkMeshCenterZ = centerZ;
+    }
+}
+// Function to apply block edits, send dirty chunks to the workers nearest the view first, within chunkMeshBudget, and
+// upload finished meshes within chunkUploadBudget
+void UpdateChunkJobs(Camera3D camera)
+{
+    PROFILE_BEGIN(ProfileChunkRemesh);
+    UpdateBlockEdits();
+    chunkMeshPosition = camera.position;
+
+    // List the chunks with sections to remesh and take them by GetChunkPriority(), so the view fills in first
+    int requestCount = 0;
+    for (int i = 0; i < CHUNK_CACHE_SIZE; i++) {
+        Chunk* chunk = &chunkCache[i];
+        if (!chunk->loaded || !chunk->terrainReady) continue;
+
+        bool dirty = false;
+        for (int sectionY = 0; sectionY < CHUNK_SECTIONS && !dirty; sectionY++) {
+            const ChunkSection* section = &chunk->sections[sectionY];
+            dirty = (section->meshNeedsUpdate || section->meshDropped) && !section->jobPending;
+        }
+        if (!dirty) continue;
+
+        // Past the distance the VRAM budget allows, changed columns drop their meshes instead of rebuilding them
+        if (IsChunkPastMeshDistance(chunk)) {
+            DropChunkMeshes(chunk);
+            continue;
+        }
+
+        // Wait for neighbours still generating, they would dirty this chunk again as soon as they finish
+        if (!AreChunkNeighboursReady(chunk)) continue;
+
+        chunkRequests[requestCount++] = (ChunkRequest){ chunk->chunkX, chunk->chunkZ, i, GetChunkPriority(chunk->chunkX, chunk->chunkZ, camera) };
+    }
+    qsort(chunkRequests, requestCount, sizeof(ChunkRequest), CompareChunkRequests);
+
+    double startTime = GetTime();
+    bool queueFull = false;
+    for (int i = 0; i < requestCount && !queueFull; i++) {
+        if (GetTime() - startTime > chunkMeshBudget) break;
+        Chunk* chunk = &chunkCache[chunkRequests[i].index];
+
+        for (int sectionY = 0; sectionY < CHUNK_SECTIONS && !queueFull; sectionY++) {
+            ChunkSection* section = &chunk->sections[sectionY];
+            if (section->jobPending || !(section->meshNeedsUpdate || section->meshDropped)) continue;
+
+            // Clear the flag first so edits made while the job runs trigger another rebuild
+            section->meshNeedsUpdate = false;
+            section->meshDropped = false;
+
+            // All-air and buried sections have no faces, skip meshing them altogether
+            if (!HasSectionFaces(chunk, sectionY)) {
+                UnloadChunkMesh(&section->mesh);
+                continue;
+            }
+
+            // The job meshes a snapshot, so neighbours can change or be evicted while it runs. Lower levels of
+            // detail are meshed without light.
+            bool lit = (chunk->lod == 0);
+            section->meshBlocks = (unsigned char*)MemAlloc(lit ? 2 * PADDED_CHUNK_VOLUME : PADDED_CHUNK_VOLUME);
+            section->meshLight = lit ? section->meshBlocks + PADDED_CHUNK_VOLUME : NULL;
+            GetChunkMeshBlocks(chunk, sectionY, section->meshBlocks);
+            if (lit) GetChunkMeshLight(chunk, sectionY, section->meshBlocks, section->meshLight);
+            section->meshMode = GetChunkMeshingMode(chunk);
+
+            section->jobPending = true;
+            chunk->pendingJobs++;
+            if (!ScheduleJob(ChunkMeshJob, ChunkMeshJobComplete, section)) {
+                MemFree(section->meshBlocks);
+                section->meshBlocks = NULL;
+                section->meshLight = NULL;
+                section->meshNeedsUpdate = true;
+                section->jobPending = false;
+                chunk->pendingJobs--;
+                queueFull = true;
+            }
+        }
+    }
+
+    PROFILE_END(ProfileChunkRemesh);
+
+    RunJobCompletions(chunkUploadBudget);
+    EnforceChunkVramBudget(camera.position);
 }
 #pragma endregion
 
 //Main gametick function.
 void UpdateGame(void)
 {
-    UpdateLizardFreeCam(EditMode, Vector3Zero());
+    BeginRenderScaleFrame();
+    BeginBenchmarkFrame(IsWorldLoaded());
+    chunkRemeshCount = 0;
+    chunkMeshReuseCount = 0;
+
+#if defined(LIZARD_PROFILER)
+    UpdateProfiler();
+    if (IsKeyPressed(KEY_F3)) profilerOverlay = !profilerOverlay;
+    if (IsKeyPressed(KEY_F4))
+    {
+        if (profilerEvents == NULL) StartProfilerCapture();
+        else SaveProfilerTrace("lizard_trace.json");
+    }
+#endif
 
-    if (IsMouseButtonDown(MOUSE_BUTTON_RIGHT))
+    PROFILE_BEGIN(ProfileCamera);
+    if (benchmarkState != BenchmarkOff)
     {
-        LastMousePos = (Vector2){ GetScreenWidth() / 2, GetScreenHeight() / 2 };
-        SetMousePosition(GetScreenWidth() / 2, GetScreenHeight() / 2);
+        GetBenchmarkCamera(&ViewCam.position, &ViewCam.target);
     }
-    if (IsMouseButtonReleased(MOUSE_BUTTON_RIGHT))
+    else
     {
-        SetMousePosition(GetScreenWidth() / 2, GetScreenHeight() / 2);
+        if (IsKeyPressed(KEY_C))
+        {
+            cameraMode = (cameraMode == FPSMode) ? EditMode : FPSMode;
+            if (cameraMode == EditMode) EnableCursor();
+        }
+
+        if (cameraMode == FPSMode) UpdateFPSCamera();
+        else UpdateLizardFreeCam(EditMode, Vector3Zero());
+
+        if (IsMouseButtonDown(MOUSE_BUTTON_RIGHT))
+        {
+            LastMousePos = (Vector2){ GetScreenWidth() / 2, GetScreenHeight() / 2 };
+            SetMousePosition(GetScreenWidth() / 2, GetScreenHeight() / 2);
+        }
+        if (IsMouseButtonReleased(MOUSE_BUTTON_RIGHT))
+        {
+            SetMousePosition(GetScreenWidth() / 2, GetScreenHeight() / 2);
+        }
+
+        UpdateBlockPicking();
+
+        // F6 records the camera as a flythrough path for --benchmark, saved when recording stops
+        if (IsKeyPressed(KEY_F6))
+        {
+            if (flythroughRecording) SaveFlythroughPath("flythrough.txt", &recordedPath);
+            recordedPath.keyCount = 0;
+            flythroughRecordStart = GetTime();
+            flythroughRecording = !flythroughRecording;
+        }
+        if (flythroughRecording)
+        {
+            float time = (float)(GetTime() - flythroughRecordStart);
+            if (recordedPath.keyCount == 0 || time - recordedPath.keys[recordedPath.keyCount - 1].time >= FLYTHROUGH_RECORD_INTERVAL)
+            {
+                RecordFlythroughKey(&recordedPath, time, ViewCam.position, ViewCam.target);
+            }
+        }
+    }
+    PROFILE_END(ProfileCamera);
+
+    // Switch between the naive and greedy mesher and rebuild every chunk
+    if (IsKeyPressed(KEY_G))
+    {
+        meshingMode = (meshingMode == MeshingGreedy) ? MeshingNaive : MeshingGreedy;
+        for (int i = 0; i < CHUNK_CACHE_SIZE; i++) {
+            for (int sectionY = 0; sectionY < CHUNK_SECTIONS; sectionY++) chunkCache[i].sections[sectionY].meshNeedsUpdate = chunkCache[i].loaded;
+        }
     }
 
+    if (IsKeyPressed(KEY_O)) occlusionCulling = !occlusionCulling;
+    if (IsKeyPressed(KEY_B)) renderScaleAuto = !renderScaleAuto;
+    if (IsKeyPressed(KEY_V)) renderFilter = (renderFilter == RenderFilterBilinear) ? RenderFilterNearest : RenderFilterBilinear;
+
     for (int i = 0; i < 256; i++)
     {
         Vector3 POS = Vector3Add(Vector3One(), Vector3Zero());
     }
 
+    // Stream chunks in and out around the camera, build them in the background and upload finished meshes
+    PROFILE_BEGIN(ProfileChunkStreaming);
+    UpdateChunkCache(ViewCam);
+    UpdateChunkLods(ViewCam.position);
+    PROFILE_END(ProfileChunkStreaming);
+    UpdateChunkJobs(ViewCam);
+    UpdateChunkAutosave();
+    UpdateRegionFiles(false);
+
     BeginTextureMode(target);
         ClearBackground(BLACK);
 
         BeginDrawing();
         ClearBackground(BLACK);
 
+        // Draw the scene into the top left renderScale part of the target only
+        int renderWidth = GetRenderScaleWidth(target);
+        int renderHeight = GetRenderScaleHeight(target);
+        rlViewport(0, 0, renderWidth, renderHeight);
+
         BeginMode3D(ViewCam);
 
+        PROFILE_BEGIN(ProfileDrawChunks);
         DrawChunks(ViewCam);
+        PROFILE_END(ProfileDrawChunks);
+
+        if (pickedBlock.hit) DrawCubeWires((Vector3){ (pickedBlock.blockX + 0.5f) * BLOCK_SIZE, (pickedBlock.blockY + 0.5f) * BLOCK_SIZE, (pickedBlock.blockZ + 0.5f) * BLOCK_SIZE }, 1.01f * BLOCK_SIZE, 1.01f * BLOCK_SIZE, 1.01f * BLOCK_SIZE, RAYWHITE);
 
 
         EndMode3D();
@@ -450,7 +1731,14 @@ void UpdateGame(void)
 
     EndTextureMode();
     
-        DrawTexturePro(target.texture, (Rectangle){ 0, 0, (float)target.texture.width, -(float)target.texture.height }, (Rectangle){ 0, 0, (float)target.texture.width, (float)target.texture.height }, (Vector2){ 0, 0 }, 0.0f, WHITE);
+        PROFILE_BEGIN(ProfileBlit);
+        Vector2 renderSize = { (float)renderWidth, (float)renderHeight };
+        BeginShaderMode(pixelatedShader);
+        SetShaderValue(pixelatedShader, pixelRenderSizeLoc, &renderSize, SHADER_UNIFORM_VEC2);
+        SetShaderValue(pixelatedShader, pixelFilterLoc, &renderFilter, SHADER_UNIFORM_INT);
+        DrawTexturePro(target.texture, (Rectangle){ 0, 0, (float)renderWidth, -(float)renderHeight }, (Rectangle){ 0, 0, (float)target.texture.width, (float)target.texture.height }, (Vector2){ 0, 0 }, 0.0f, WHITE);
+        EndShaderMode();
+        PROFILE_END(ProfileBlit);
       //  DrawTexture(LOGO, 150, 0, WHITE);
 
        /* if (IsKeyDown(KEY_F))
@@ -462,34 +1750,105 @@ void UpdateGame(void)
             DrawText("Hopefully it works - Lizard, 2024", GetScreenWidth() / 2, GetScreenHeight() / 2, 20, BLUE);
         }*/
         DrawFPS(16, GetScreenHeight() - 32);
+        DrawText(TextFormat("%s mesher (G): %i vertices", (meshingMode == MeshingGreedy) ? "Greedy" : "Naive", drawnVertexCount), 16, GetScreenHeight() - 48, 10, LIME);
+        DrawText(TextFormat("Sections: %i drawn, %i culled, %i occluded (O: %s), %i chunks", drawnSectionCount, culledChunkCount, occludedSectionCount, occlusionCulling ? "on" : "off", residentChunkCount), 16, GetScreenHeight() - 60, 10, LIME);
+        DrawText(TextFormat("Block data: %i KB", GetResidentBlockBytes() / 1024), 16, GetScreenHeight() - 72, 10, LIME);
+        DrawText(TextFormat("Chunk draws: %i calls, %i vertex pages, VRAM %i of %i MB used, %i MB allocated", chunkDrawCallCount, chunkPageCount,
+            (int)(chunkVramUsedBytes / (1024 * 1024)), (int)(chunkVramBudget / (1024 * 1024)), (int)(chunkVramBytes / (1024 * 1024))), 16, GetScreenHeight() - 84, 10, LIME);
+        DrawText(TextFormat("%s camera (C), left click breaks, middle click places (shift: lamp)", (cameraMode == FPSMode) ? "Walking" : "Free"), 16, GetScreenHeight() - 96, 10, LIME);
+        DrawText(TextFormat("Render scale: %i%% %ix%i (B: %s), %s upscale (V), %.1f ms CPU", (int)(renderScale * 100.0f + 0.5f), renderWidth, renderHeight,
+            renderScaleAuto ? "auto" : "off", (renderFilter == RenderFilterBilinear) ? "bilinear" : "nearest", frameCpuAverage * 1000.0f), 16, GetScreenHeight() - 108, 10, LIME);
+        if (benchmarkState == BenchmarkWarmup) DrawText(TextFormat("Benchmark: loading the world, frame %i", benchmarkWarmupFrames), 16, GetScreenHeight() - 120, 10, YELLOW);
+        else if (benchmarkState == BenchmarkRunning) DrawText(TextFormat("Benchmark: frame %i of %i", benchmarkFrameCount + 1, benchmarkFrameCapacity), 16, GetScreenHeight() - 120, 10, YELLOW);
+        else if (flythroughRecording) DrawText(TextFormat("Recording flythrough (F6 stops): %i keys", recordedPath.keyCount), 16, GetScreenHeight() - 120, 10, YELLOW);
+#if defined(LIZARD_PROFILER)
+        DrawProfiler(16, 16);
+#endif
 
+    EndBenchmarkFrame((BenchmarkFrame){ 0.0f, 0.0f, drawnSectionCount, chunkDrawCallCount, drawnVertexCount / 2, chunkRemeshCount, (int)(chunkVramBytes / 1024), ViewCam.position });
+    EndRenderScaleFrame();
     EndDrawing();
 }
 
-//Entry point 
-int main(void)
+//Entry point. raylib_game --benchmark [path] plays a flythrough path (or a built-in one) over a world that is not
+//saved, writes benchmark_frames.csv and benchmark_summary.txt and exits. --seed n picks the world seed, --vram-budget mb
+//the GPU memory chunk meshes may use.
+int main(int argc, char* argv[])
 {
+    const char* benchmarkPathFile = NULL;
+    bool benchmark = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--benchmark") == 0)
+        {
+            benchmark = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') benchmarkPathFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) worldSeed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--vram-budget") == 0 && i + 1 < argc) chunkVramBudget = (size_t)strtoul(argv[++i], NULL, 10) * 1024 * 1024;
+    }
+
     InitWindow(screenWidth, screenHeight, "raylib gamejam template");
     target = LoadRenderTexture(screenWidth, screenHeight);
     SetTextureFilter(target.texture, TEXTURE_FILTER_BILINEAR);
+    pixelatedShader = LoadShader(0, TextFormat("resources/shader/glsl%i/pixel.fs", GLSL_VERSION));
+    pixelRenderSizeLoc = GetShaderLocation(pixelatedShader, "renderSize");
+    pixelFilterLoc = GetShaderLocation(pixelatedShader, "filterMode");
+    Vector2 targetSize = { (float)target.texture.width, (float)target.texture.height };
+    Vector2 pixelSize = { 1.0f, 1.0f };
+    SetShaderValue(pixelatedShader, GetShaderLocation(pixelatedShader, "textureSize"), &targetSize, SHADER_UNIFORM_VEC2);
+    SetShaderValue(pixelatedShader, GetShaderLocation(pixelatedShader, "pixelSize"), &pixelSize, SHADER_UNIFORM_VEC2);
     InitLizardFreeCam(70.0f);
     LOGO = LoadTexture("resources/logo.png");
-    BLOCKS = LoadTexture("resources/blocks.png");
-    perlinImage = GenImagePerlinNoise(CHUNK_SIZE * WORLD_WIDTH, CHUNK_SIZE * WORLD_WIDTH, 0.0f , 0.0f, 1.5f);
-    perlinTexture = LoadTextureFromImage(perlinImage);
-
+    InitBlockTypes();
+    Vector2 tileSize = { 0 };
+    BLOCKS = LoadBlockAtlas("resources/blocks.png", &tileSize);
+    chunkShader = LoadShader(TextFormat("resources/shader/glsl%i/lizard.vs", GLSL_VERSION), TextFormat("resources/shader/glsl%i/lizard.fs", GLSL_VERSION));
+    chunkTileLoc = GetShaderLocationAttrib(chunkShader, "vertexTile");
+    Vector4 white = { 1.0f, 1.0f, 1.0f, 1.0f };
+    SetShaderValue(chunkShader, GetShaderLocation(chunkShader, "tileSize"), &tileSize, SHADER_UNIFORM_VEC2);
+    SetShaderValue(chunkShader, chunkShader.locs[SHADER_LOC_COLOR_DIFFUSE], &white, SHADER_UNIFORM_VEC4);
+    ViewCam.position = (Vector3){ 0.0f, heightScale + 8.0f, 0.0f };
+    ViewCam.target = (Vector3){ 0.0f, heightScale + 8.0f, 1.0f };
+
+    LoadChunkIndexBuffer();
+
+    if (benchmark)
+    {
+        FlythroughPath* path = (FlythroughPath*)MemAlloc(sizeof(FlythroughPath));
+        if (benchmarkPathFile == NULL || !LoadFlythroughPath(benchmarkPathFile, path)) GenerateFlythroughPath(path, ViewCam.position, 96.0f, 8.0f, 20.0f);
+        StartBenchmark(path);
+        MemFree(path);
+        renderScaleAuto = false; // Same resolution every run
+    }
+    InitRegionFiles(benchmark ? NULL : "saves");
+    InitLight(GetBlock, GetLight, SetLight);
+    InitJobSystem(0);
     InitChunks();
 
     #if defined(PLATFORM_WEB)
+        EM_ASM({
+            document.addEventListener("visibilitychange", function() { if (document.visibilityState === "hidden") Module._OnPageHidden(); });
+            window.addEventListener("pagehide", function() { Module._OnPageHidden(); });
+        });
         emscripten_set_main_loop(UpdateGame, 60, 1);
     #else
-    SetTargetFPS(60);     
-    while (!WindowShouldClose())
+    SetTargetFPS(benchmark ? 0 : 60);
+    while (!WindowShouldClose() && benchmarkState != BenchmarkDone)
     {
         UpdateGame();
     }
     #endif
 
+    if (benchmarkState == BenchmarkDone) SaveBenchmarkResults("benchmark_frames.csv", "benchmark_summary.txt");
+
+    ShutdownJobSystem();
+    SaveChunks();
+    CloseRegionFiles();
+    ShutdownLight();
+    UnloadChunkIndexBuffer();
+    UnloadShader(chunkShader);
+    UnloadShader(pixelatedShader);
     UnloadRenderTexture(target);
     CloseWindow();
     return 0;
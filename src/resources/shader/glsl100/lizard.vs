@@ -0,0 +1,38 @@
+#version 100
+
+// Input vertex attributes, packed as unsigned bytes (see ChunkVertex)
+attribute vec4 vertexPosition;      // xyz: position in blocks inside the chunk region, w: face direction index
+attribute vec4 vertexTile;          // xy: atlas cell column and row, z: sky light*16 + block light, w: ambient occlusion 0..3
+
+// Input uniform values
+uniform mat4 mvp;
+uniform vec2 tileSize;
+
+// Output vertex attributes (to fragment shader)
+varying vec2 fragTexCoord;
+varying vec2 fragTileCoord;
+varying float fragLight;
+
+void main()
+{
+    vec3 position = vertexPosition.xyz;
+    float face = vertexPosition.w;
+
+    // Texture coordinates in block units from the two axes the face spans (faceDirections order)
+    vec2 texCoord = position.xy;                        // Front/back (-z/+z): u = x, v = y
+    if (face < 1.5) texCoord = position.zy;             // Left/right (-x/+x): u = z, v = y
+    else if (face < 2.5) texCoord = position.xz;        // Bottom (-y): u = x, v = z
+    else if (face < 3.5) texCoord = position.zx;        // Top (+y): u = z, v = x
+
+    // Send vertex attributes to fragment shader
+    fragTexCoord = texCoord;
+    fragTileCoord = (vertexTile.xy*2.0 + 0.5)*tileSize;  // Skip the cell's wrapped border, half a tile wide
+
+    // Brightest of sky and block light, each level a fifth darker, and a fifth darker per occluding block
+    float sky = floor(vertexTile.z/16.0);
+    float level = max(sky, vertexTile.z - sky*16.0);
+    fragLight = pow(0.8, 15.0 - level)*(1.0 - vertexTile.w*0.2);
+
+    // Calculate final vertex position
+    gl_Position = mvp*vec4(position, 1.0);
+}
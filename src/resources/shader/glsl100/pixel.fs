@@ -0,0 +1,30 @@
+#version 100
+
+precision mediump float;
+
+// Input vertex attributes (from vertex shader)
+varying vec2 fragTexCoord;
+varying vec4 fragColor;
+
+// Input uniform values
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+
+// Render size values, passed from code (see LizardRenderScale.h)
+uniform vec2 textureSize;       // Render texture size, in texels
+uniform vec2 renderSize;        // Part of the render texture the scene was drawn to, in texels
+uniform vec2 pixelSize;         // Texels shown as one big pixel with nearest filtering
+uniform int filterMode;         // 0: nearest, 1: bilinear
+
+void main()
+{
+    vec2 texel = fragTexCoord*textureSize;
+
+    // Nearest: sample the centre of a texel, bilinear: stay half a texel inside the rendered part
+    if (filterMode == 0) texel = floor(texel/pixelSize)*pixelSize + 0.5;
+    else texel = clamp(texel, vec2(0.5), renderSize - 0.5);
+
+    vec3 tc = texture2D(texture0, texel/textureSize).rgb;
+
+    gl_FragColor = vec4(tc, 1.0);
+}